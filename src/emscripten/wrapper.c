@@ -1,20 +1,14 @@
+#include <emu.h>
 #include <cart.h>
 #include <timer.h>
 #include <cpu.h>
 #include <ppu.h>
-#include <dma.h>
 #include <sound.h>
 #include <gamepad.h>
+#include <state.h>
 #include <unistd.h>
 #include <string.h>
 
-typedef struct {
-    bool paused;
-    bool running;
-    bool die;
-    u64 ticks;
-} emu_context;
-
 struct Emulator {
     emu_context *emu_ctx;
     cart_context *cart_ctx;
@@ -22,8 +16,9 @@ struct Emulator {
     cpu_context *cpu_ctx;
     ppu_context *ppu_ctx;
     gamepad_context *gamepad_ctx;
-    sound_context *sound_ctx;
+    sound_buffer audio;
     u32 event;
+    u32 presented_frame;
 };
 
 typedef struct {
@@ -40,7 +35,33 @@ emu_context *emu_get_context() {
     return &emu_ctx;
 }
 
+static void emu_cycles_double(int cpu_cycles) {
+    emu_ctx.cycles += cpu_cycles;
+
+    for (int i=0; i<cpu_cycles; i++) {
+        for (int n=0; n<2; n++) {
+            emu_ctx.ticks++;
+            timer_tick();
+            timer_tick();
+            ppu_tick();
+        }
+
+        sound_tick(1);
+    }
+
+    if (emu_ctx.next_event && emu_ctx.cycles >= emu_ctx.next_event) {
+        scheduler_run();
+    }
+}
+
 void emu_cycles(int cpu_cycles) {
+    if (cpu_get_context()->double_speed) {
+        emu_cycles_double(cpu_cycles);
+        return;
+    }
+
+    emu_ctx.cycles += cpu_cycles;
+
     for (int i=0; i<cpu_cycles; i++) {
         for (int n=0; n<4; n++) {
             emu_ctx.ticks++;
@@ -49,7 +70,10 @@ void emu_cycles(int cpu_cycles) {
         }
 
         sound_tick(2);
-        dma_tick();
+    }
+
+    if (emu_ctx.next_event && emu_ctx.cycles >= emu_ctx.next_event) {
+        scheduler_run();
     }
 }
 
@@ -76,7 +100,6 @@ Emulator* emulator_new(void* rom_data, size_t rom_size,
     e->cpu_ctx = cpu_get_context();
     e->ppu_ctx = ppu_get_context();
     e->gamepad_ctx = gamepad_get_context();
-    e->sound_ctx = sound_get_context();
 
     if (!cart_init(rom_data, rom_size)) {
         printf("Failed to load ROM file");
@@ -87,6 +110,7 @@ Emulator* emulator_new(void* rom_data, size_t rom_size,
     cpu_init();
     ppu_init();
     emu_init();
+    sound_set_sink(&sound_sink_buffer, &e->audio);
     sound_init(audio_frequency, audio_frames);
 
     return e;
@@ -94,16 +118,19 @@ Emulator* emulator_new(void* rom_data, size_t rom_size,
 
 void emulator_delete(Emulator *e) {
     if (e) {
+        sound_close();
         free(e);
     }
 }
 
 bool emulator_read_ext_ram(Emulator *e, const FileData *file_data) {
-    if (!e->cart_ctx->battery || !e->cart_ctx->ram_bank) {
+    if (!e->cart_ctx->battery || !cart_ram_size()) {
         return 1;
     }
 
-    memcpy(e->cart_ctx->ram_bank, file_data->data, file_data->size);
+    //all banks, older saves only hold the first one.
+    u32 size = file_data->size < cart_ram_size() ? file_data->size : cart_ram_size();
+    page_write(e->cart_ctx->ram_pages, 0, file_data->data, size);
     return 1;
 }
 
@@ -123,22 +150,35 @@ double emulator_get_ticks(Emulator *e) {
 u8 emulator_run_until(Emulator *e, double until_ticks) {
     u64 until_ticks_u = (u64) until_ticks;
     u32 prev_frame = e->ppu_ctx->current_frame;
+    sound_buffer *audio = &e->audio;
     e->event = 0x0;
+
+    //the page took the full buffer reported last time, what came after it moves up.
+    if (audio->pos >= audio->frames) {
+        audio->pos -= audio->frames;
+        memmove(audio->data, audio->data + audio->frames * 2, audio->pos * 2);
+    }
+
     while(e->emu_ctx->running && (e->event == 0)) {
         if (e->emu_ctx->ticks > until_ticks_u) {
             e->event |= 0x4;
         }
 
-        if (e->sound_ctx->pos >= e->sound_ctx->frames * 2 + e->sound_ctx->skip_frames * 2) {
+        if (audio->pos >= audio->frames) {
             e->event |= 0x2;
-            e->sound_ctx->pos = 0;
         }
 
         // run one cpu step
         cpu_step();
 
         if (prev_frame != e->ppu_ctx->current_frame) {
-            e->event |= 0x1;
+            //only report frames that differ from the last reported one.
+            if (ppu_frame_changed(e->presented_frame, NULL, NULL)) {
+                e->event |= 0x1;
+            }
+
+            prev_frame = e->ppu_ctx->current_frame;
+            e->presented_frame = prev_frame;
         }
     }
 
@@ -157,12 +197,31 @@ bool emulator_was_ext_ram_updated(Emulator *e) {
 
 FileData* ext_ram_file_data_new(Emulator *e) {
     FileData* file_data = malloc(sizeof(FileData));
-    e->cart_ctx->ext_ram_size = 0x2000;
+    e->cart_ctx->ext_ram_size = cart_ram_size() ? cart_ram_size() : CART_RAM_BANK_SIZE;
     file_data->size = e->cart_ctx->ext_ram_size;
     file_data->data = malloc(file_data->size);
     return file_data;
 }
 
+FileData* file_data_new(size_t size) {
+    FileData* file_data = malloc(sizeof(FileData));
+    file_data->size = size;
+    file_data->data = malloc(file_data->size);
+    return file_data;
+}
+
+FileData* state_file_data_new(Emulator *e) {
+    return file_data_new(state_size());
+}
+
+bool emulator_save_state(Emulator *e, FileData *file_data) {
+    return state_save(file_data->data, file_data->size) != 0;
+}
+
+bool emulator_load_state(Emulator *e, const FileData *file_data) {
+    return state_load(file_data->data, file_data->size);
+}
+
 void* get_file_data_ptr(FileData *file_data) {
     return file_data->data;
 }
@@ -177,11 +236,11 @@ void file_data_delete(FileData* file_data) {
 }
 
 void* get_audio_buffer_ptr(Emulator* e) {
-    return e->sound_ctx->buf;
+    return e->audio.data;
 }
 
 size_t get_audio_buffer_capacity(Emulator* e) {
-    return e->sound_ctx->len;
+    return e->audio.capacity * 2;
 }
 
 void* get_frame_buffer_ptr(Emulator* e) {
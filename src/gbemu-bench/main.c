@@ -0,0 +1,778 @@
+#include <emu.h>
+#include <cart.h>
+#include <cpu.h>
+#include <timer.h>
+#include <ppu.h>
+#include <sound.h>
+#include <rewind.h>
+#include <runahead.h>
+#include <movie.h>
+#include <vecenv.h>
+#include <gamepad.h>
+#include <bus.h>
+#include <link.h>
+#include <netplay.h>
+#include <machine.h>
+
+#include <time.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+/**
+    Headless benchmark, runs the rom without ui or audio and reports the
+    emulated frames per second for a set of frame skip ratios, the memory
+    and time the rewind buffer costs, the speed with run-ahead and the
+    frames per second of vectorized environments.
+
+    With --movie the recorded input is replayed as fast as possible instead,
+    reporting the speed, the desyncs against the recorded state hashes and
+    the hash of the final state.
+
+    --bank-stress builds an 8MB MBC5 rom whose code switches to every one
+    of its 512 rom banks in turn, a switch every few cycles, and checks
+    that each bank reads back its own number.
+
+    --link runs two machines playing ping-pong over the link cable, in
+    process on one and on two threads and over a socket, and reports the
+    speed of each against a single machine and the rollbacks.
+
+    --netplay rolls back both machines of a netplay session further and
+    further until running the frames again no longer fits in a frame's
+    16.7 ms, then plays a session between two processes over a datagram
+    socket with latency and loss injected, and checks that both players
+    end in the same state.
+
+    usage: gbemu-bench <rom file> [frames per ratio | --movie <movie file>]
+           gbemu-bench --bank-stress [frames]
+           gbemu-bench --link [frames]
+           gbemu-bench --netplay <rom file> [frames] [latency ms] [loss %]
+ */
+
+static const int skip_ratios[] = {1, 2, 4, 8};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void run_frames(u32 frames, int ratio, bool rewind) {
+    ppu_context *ppu = ppu_get_context();
+    u32 end_frame = ppu->current_frame + frames;
+    u32 prev_frame = ppu->current_frame;
+
+    //render one frame out of every ratio frames.
+    ppu_set_frame_render(ratio <= 1);
+
+    while (ppu->current_frame < end_frame) {
+        if (!cpu_step()) {
+            printf("CPU Stopped\n");
+            exit(-1);
+        }
+
+        if (prev_frame != ppu->current_frame) {
+            prev_frame = ppu->current_frame;
+            ppu_set_frame_render((prev_frame % ratio) == 0);
+
+            if (rewind) {
+                rewind_push();
+            }
+        }
+    }
+}
+
+static int replay_movie(char *filename) {
+    if (!movie_play_start(filename)) {
+        return -3;
+    }
+
+    ppu_context *ppu = ppu_get_context();
+    u32 prev_frame = ppu->current_frame;
+
+    double start = now();
+
+    while (!movie_finished()) {
+        if (!cpu_step()) {
+            printf("CPU Stopped\n");
+            return -4;
+        }
+
+        if (prev_frame != ppu->current_frame) {
+            prev_frame = ppu->current_frame;
+            movie_frame();
+        }
+    }
+
+    double fps = movie_get_frames() / (now() - start);
+
+    printf("\nmovie    %10u frames %10.1f fps\n", movie_get_frames(), fps);
+    printf("  desyncs %u, first at frame %d\n", movie_get_desyncs(), movie_first_desync());
+    printf("  final state hash %016llx\n", (unsigned long long)movie_state_hash());
+
+    int desyncs = movie_get_desyncs();
+    movie_stop();
+
+    return desyncs ? 1 : 0;
+}
+
+//selects bank bc (low byte to 2000, bit 8 to 3000), checks that 4000/4001
+//hold c/b, bc = (bc + 1) & 0x1FF, counts the passes over all banks in FF81.
+//a mismatch stores 1 in FF80 and stops there.
+static const u8 bank_stress_code[] = {
+    0xF3,                   //0150 di
+    0x01, 0x00, 0x00,       //0151 ld bc,0
+    0x79,                   //0154 loop: ld a,c
+    0xEA, 0x00, 0x20,       //0155 ld (2000),a
+    0x78,                   //0158 ld a,b
+    0xEA, 0x00, 0x30,       //0159 ld (3000),a
+    0xFA, 0x00, 0x40,       //015C ld a,(4000)
+    0xB9,                   //015F cp c
+    0x20, 0x15,             //0160 jr nz,fail
+    0xFA, 0x01, 0x40,       //0162 ld a,(4001)
+    0xB8,                   //0165 cp b
+    0x20, 0x0F,             //0166 jr nz,fail
+    0x03,                   //0168 inc bc
+    0x78,                   //0169 ld a,b
+    0xE6, 0x01,             //016A and 1
+    0x47,                   //016C ld b,a
+    0xB1,                   //016D or c
+    0x20, 0xE4,             //016E jr nz,loop
+    0xF0, 0x81,             //0170 ldh a,(81)
+    0x3C,                   //0172 inc a
+    0xE0, 0x81,             //0173 ldh (81),a
+    0x18, 0xDD,             //0175 jr loop
+    0x3E, 0x01,             //0177 fail: ld a,1
+    0xE0, 0x80,             //0179 ldh (80),a
+    0x18, 0xFE              //017B jr fail+4
+};
+
+static int bank_stress(u32 frames) {
+    const u32 banks = 512;
+    u8 *rom = calloc(banks, 0x4000);
+
+    for (u32 i=1; i<banks; i++) {
+        rom[i * 0x4000] = i & 0xFF;
+        rom[i * 0x4000 + 1] = i >> 8;
+    }
+
+    rom[0x100] = 0x00; //nop
+    rom[0x101] = 0xC3; //jp 0150
+    rom[0x102] = 0x50;
+    rom[0x103] = 0x01;
+    memcpy(rom + 0x134, "BANKSTRESS", 10);
+    rom[0x147] = 0x19; //mbc5
+    rom[0x148] = 0x08; //8MB
+    memcpy(rom + 0x150, bank_stress_code, sizeof(bank_stress_code));
+
+    cart_set_quiet(true);
+
+    if (!cart_init(rom, banks * 0x4000)) {
+        return -2;
+    }
+
+    free(rom);
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+    ppu_set_frame_render(false);
+    emu_get_context()->running = true;
+
+    ppu_context *ppu = ppu_get_context();
+    u32 end_frame = ppu->current_frame + frames;
+    double start = now();
+
+    while (ppu->current_frame < end_frame && !bus_read(0xFF80)) {
+        cpu_step();
+    }
+
+    double seconds = now() - start;
+    u32 passes = bus_read(0xFF81);
+
+    printf("\nbank stress %u frames, %u passes over %u banks, %.1f fps, %s\n",
+        frames, passes, banks, frames / seconds, bus_read(0xFF80) ? "FAILED" : "ok");
+
+    return bus_read(0xFF80) || !passes ? 1 : 0;
+}
+
+//both sides run this, FF90 picks the side. The clock side sends 0, 1, 2...
+//and expects each byte back, the other side answers with the last byte
+//it got plus 1. A wrong answer stores 1 in FF80.
+static const u8 link_pong_code[] = {
+    0xF3,                   //0150 di
+    0xAF,                   //0151 xor a
+    0xE0, 0x80,             //0152 ldh (80),a
+    0xE0, 0x01,             //0154 ldh (01),a
+    0xF0, 0x90,             //0156 ldh a,(90)
+    0xB7,                   //0158 or a
+    0x20, 0x1A,             //0159 jr nz,answer
+    0x06, 0x00,             //015B ld b,0
+    0x78,                   //015D send: ld a,b
+    0xE0, 0x01,             //015E ldh (01),a
+    0x3E, 0x81,             //0160 ld a,81
+    0xE0, 0x02,             //0162 ldh (02),a
+    0xF0, 0x02,             //0164 wait: ldh a,(02)
+    0x87,                   //0166 add a
+    0x38, 0xFB,             //0167 jr c,wait
+    0xF0, 0x01,             //0169 ldh a,(01)
+    0xB8,                   //016B cp b
+    0x28, 0x04,             //016C jr z,ok
+    0x3E, 0x01,             //016E ld a,1
+    0xE0, 0x80,             //0170 ldh (80),a
+    0x04,                   //0172 ok: inc b
+    0x18, 0xE8,             //0173 jr send
+    0x3E, 0x80,             //0175 answer: ld a,80
+    0xE0, 0x02,             //0177 ldh (02),a
+    0xF0, 0x02,             //0179 wait: ldh a,(02)
+    0x87,                   //017B add a
+    0x38, 0xFB,             //017C jr c,wait
+    0xF0, 0x01,             //017E ldh a,(01)
+    0x3C,                   //0180 inc a
+    0xE0, 0x01,             //0181 ldh (01),a
+    0x18, 0xF0              //0183 jr answer
+};
+
+static machine *link_machine(u8 side) {
+    u8 *rom = calloc(1, 0x8000);
+
+    rom[0x100] = 0x00; //nop
+    rom[0x101] = 0xC3; //jp 0150
+    rom[0x102] = 0x50;
+    rom[0x103] = 0x01;
+    memcpy(rom + 0x134, "LINKPONG", 8);
+    memcpy(rom + 0x150, link_pong_code, sizeof(link_pong_code));
+
+    machine *m = machine_new();
+    machine_bind(m);
+
+    cart_set_quiet(true);
+    cart_init(rom, 0x8000);
+    free(rom);
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+    ppu_set_frame_render(false);
+    emu_get_context()->running = true;
+
+    bus_write(0xFF90, side);
+
+    return m;
+}
+
+typedef struct {
+    machine *m;
+    link_cable *cable;
+    u64 ticks;
+    atomic_int *done;
+    bool connected;
+} link_side;
+
+//each side keeps its end of the socket answering until both are done.
+static void *link_socket_side(void *p) {
+    link_side *side = p;
+
+    machine_bind(side->m);
+
+    emu_context *emu = emu_get_context();
+    u64 end = emu->ticks + side->ticks;
+    bool counted = false;
+
+    side->connected = true;
+
+    while (!counted || atomic_load(side->done) < 2) {
+        cpu_step();
+        side->connected = link_poll(side->cable) && side->connected;
+
+        if (!counted && emu->ticks >= end) {
+            atomic_fetch_add(side->done, 1);
+            counted = true;
+        }
+    }
+
+    return 0;
+}
+
+//the overhead is against the single machine, per machine and thread. false if the game saw a wrong byte.
+static bool link_report(const char *name, u32 frames, double seconds, double single, int per_thread,
+        machine *clock, link_cable *cable) {
+    link_stats stats;
+    link_get_stats(cable, &stats);
+
+    machine_bind(clock);
+    bool ok = !bus_read(0xFF80) && stats.transfers;
+
+    printf("%-10s %8u %10.1f %8.1f%%\n", name, frames, frames / seconds,
+        (seconds / (single * per_thread) - 1) * 100);
+    printf("  %u transfers, %u predicted, %u rollbacks (%.1f frames run again), %u stalls, %s\n",
+        stats.transfers, stats.speculations, stats.rollbacks,
+        stats.rollback_ticks / (double)(LINES_PER_FRAME * TICKS_PER_LINE), stats.stalls, ok ? "ok" : "FAILED");
+
+    return ok;
+}
+
+static int link_bench(u32 frames) {
+    u64 ticks = (u64)frames * LINES_PER_FRAME * TICKS_PER_LINE;
+    int failed = 0;
+
+    printf("\n%-10s %8s %10s %9s\n", "link", "frames", "fps", "overhead");
+
+    //one machine on its own, what the cable costs is measured against it.
+    machine *m = link_machine(0);
+    double start = now();
+
+    while (emu_get_context()->ticks < ticks) {
+        cpu_step();
+    }
+
+    double single = now() - start;
+    printf("%-10s %8u %10.1f %9s\n", "single", frames, frames / single, "-");
+    machine_free(m);
+
+    for (int threads=1; threads<=2; threads++) {
+        machine *a = link_machine(0);
+        machine *b = link_machine(1);
+        link_cable *cable = link_local(a, b, threads);
+
+        start = now();
+        link_run(cable, ticks);
+        double seconds = now() - start;
+
+        if (!link_report(threads == 1 ? "1 thread" : "2 threads", frames, seconds, single, threads == 1 ? 2 : 1, a, cable)) {
+            failed = 1;
+        }
+
+        link_free(cable);
+        machine_free(a);
+        machine_free(b);
+    }
+
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+        printf("socketpair failed\n");
+        return 1;
+    }
+
+    atomic_int done = 0;
+    link_side sides[2];
+    pthread_t threads[2];
+
+    for (int i=0; i<2; i++) {
+        sides[i].m = link_machine(i);
+        sides[i].cable = link_socket(fds[i]);
+        sides[i].ticks = ticks;
+        sides[i].done = &done;
+    }
+
+    start = now();
+
+    for (int i=0; i<2; i++) {
+        pthread_create(&threads[i], NULL, link_socket_side, &sides[i]);
+    }
+
+    for (int i=0; i<2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = now() - start;
+
+    if (!link_report("socket", frames, seconds, single, 1, sides[0].m, sides[0].cable) || !sides[0].connected) {
+        failed = 1;
+    }
+
+    for (int i=0; i<2; i++) {
+        machine_bind(sides[i].m);
+        link_free(sides[i].cable);
+        machine_free(sides[i].m);
+    }
+
+    return failed;
+}
+
+typedef struct {
+    machine *m[2];
+    netplay *np;
+} netplay_peer;
+
+static machine *netplay_machine(const char *rom_file) {
+    machine *m = machine_new();
+    machine_bind(m);
+
+    cart_set_quiet(true);
+
+    if (!cart_load((char *)rom_file)) {
+        printf("Failed to load ROM file: %s\n", rom_file);
+        exit(-2);
+    }
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+    ppu_set_frame_render(false);
+    emu_get_context()->running = true;
+    emu_get_context()->fast_forward = true;
+
+    return m;
+}
+
+static void netplay_peer_init(netplay_peer *peer, const char *rom_file, netplay_config *config) {
+    for (int i=0; i<2; i++) {
+        peer->m[i] = netplay_machine(rom_file);
+    }
+
+    peer->np = netplay_new(peer->m[0], peer->m[1], config);
+}
+
+static void netplay_peer_free(netplay_peer *peer) {
+    netplay_free(peer->np);
+
+    for (int i=1; i>=0; i--) {
+        machine_bind(peer->m[i]);
+        machine_free(peer->m[i]);
+    }
+}
+
+//a button pattern that changes every few frames, different for each player.
+static u8 netplay_input(int player, u32 frame) {
+    u32 x = (frame / 8 + 1) * 2654435761u ^ (player + 1) * 40503u;
+    x ^= x >> 15;
+
+    return (x & 0xF0) | ((x >> 8) & (GAMEPAD_A | GAMEPAD_B));
+}
+
+//the player runs the frames at 60 per second, then waits for all inputs.
+//0 if they didn't arrive.
+static u64 netplay_session(netplay *np, int player, u32 frames) {
+    double start = now();
+
+    for (u32 frame=0; frame<frames; ) {
+        if (!netplay_frame(np, netplay_input(player, frame))) {
+            usleep(1000);
+            continue;
+        }
+
+        frame++;
+        double wait = start + frame / 60.0 - now();
+
+        if (wait > 0) {
+            usleep(wait * 1e6);
+        }
+    }
+
+    return netplay_flush(np, 5000) ? netplay_state_hash(np) : 0;
+}
+
+static int netplay_bench(const char *rom_file, u32 frames, u32 latency_ms, float loss) {
+    int fds[2];
+    int failed = 0;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds)) {
+        printf("socketpair failed\n");
+        return 1;
+    }
+
+    //both players in this process without latency, then rollbacks of
+    //growing depth on the first one's machines.
+    netplay_peer peers[2];
+
+    for (int i=0; i<2; i++) {
+        netplay_config config = {0};
+        config.player = i;
+        config.fd = fds[i];
+        config.max_rollback = NETPLAY_MAX_ROLLBACK;
+
+        netplay_peer_init(&peers[i], rom_file, &config);
+    }
+
+    u32 warmup = NETPLAY_MAX_ROLLBACK * 2;
+
+    while (netplay_get_frame(peers[0].np) < warmup || netplay_get_frame(peers[1].np) < warmup) {
+        for (int i=0; i<2; i++) {
+            u32 frame = netplay_get_frame(peers[i].np);
+
+            if (frame < warmup) {
+                netplay_frame(peers[i].np, netplay_input(i, frame));
+            }
+        }
+    }
+
+    netplay *np = peers[0].np;
+    u64 hash = netplay_state_hash(np);
+    double budget = 1000 / 60.0;
+    u32 best = 0;
+
+    printf("\n%-8s %10s %8s\n", "depth", "ms", "fits");
+
+    for (u32 depth=1; depth<=NETPLAY_MAX_ROLLBACK; depth++) {
+        double start = now();
+
+        for (int i=0; i<3; i++) {
+            netplay_resimulate(np, depth);
+        }
+
+        double ms = (now() - start) * 1000 / 3;
+        printf("%-8u %10.2f %8s\n", depth, ms, ms <= budget ? "yes" : "no");
+
+        if (ms > budget) {
+            break;
+        }
+
+        best = depth;
+    }
+
+    if (netplay_state_hash(np) != hash) {
+        printf("rolled back state differs\n");
+        failed = 1;
+    }
+
+    printf("max rollback depth within %.1f ms: %u frames\n", budget, best);
+
+    for (int i=0; i<2; i++) {
+        netplay_peer_free(&peers[i]);
+        close(fds[i]);
+    }
+
+    //two processes, a player each, with latency and loss on both sides.
+    int results[2];
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) || pipe(results)) {
+        printf("socketpair failed\n");
+        return 1;
+    }
+
+    fflush(stdout);
+    pid_t child = fork();
+
+    if (child < 0) {
+        printf("fork failed\n");
+        return 1;
+    }
+
+    int player = child == 0;
+    netplay_config config = {0};
+    config.player = player;
+    config.fd = fds[player];
+    config.latency_ms = latency_ms;
+    config.loss = loss;
+    config.seed = 1 + player;
+
+    close(fds[!player]);
+    netplay_peer_init(&peers[player], rom_file, &config);
+    hash = netplay_session(peers[player].np, player, frames);
+
+    if (child == 0) {
+        write(results[1], &hash, sizeof(hash));
+        _exit(0);
+    }
+
+    u64 remote_hash = 0;
+
+    if (read(results[0], &remote_hash, sizeof(remote_hash)) != sizeof(remote_hash)) {
+        remote_hash = 0;
+    }
+
+    waitpid(child, NULL, 0);
+
+    netplay_stats stats;
+    netplay_get_stats(peers[player].np, &stats);
+
+    printf("\nsession  %u frames, %u ms latency, %.0f%% loss each way\n", frames, latency_ms, loss * 100);
+    printf("  rollbacks %u, depth %.2f avg %u max, %.2f ms avg %.2f ms max\n",
+        stats.rollbacks, stats.rollbacks ? (double)stats.rollback_frames / stats.rollbacks : 0, stats.max_depth,
+        stats.rollbacks ? stats.rollback_ms / stats.rollbacks : 0, stats.max_rollback_ms);
+    printf("  waits %u, datagrams %u sent %u dropped %u received\n",
+        stats.waits, stats.sent, stats.dropped, stats.received);
+
+    if (!hash || hash != remote_hash) {
+        printf("  players DESYNCED: %016llx %016llx\n", (unsigned long long)hash, (unsigned long long)remote_hash);
+        failed = 1;
+    } else {
+        printf("  players in sync: %016llx\n", (unsigned long long)hash);
+    }
+
+    netplay_peer_free(&peers[player]);
+    close(fds[player]);
+    close(results[0]);
+    close(results[1]);
+
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s <rom file> [frames per ratio | --movie <movie file>]\n", argv[0]);
+        printf("       %s --bank-stress [frames]\n", argv[0]);
+        printf("       %s --link [frames]\n", argv[0]);
+        printf("       %s --netplay <rom file> [frames] [latency ms] [loss %%]\n", argv[0]);
+        return -1;
+    }
+
+    if (!strcmp(argv[1], "--bank-stress")) {
+        return bank_stress(argc > 2 ? atoi(argv[2]) : 600);
+    }
+
+    if (!strcmp(argv[1], "--link")) {
+        return link_bench(argc > 2 ? atoi(argv[2]) : 600);
+    }
+
+    if (!strcmp(argv[1], "--netplay") && argc > 2) {
+        return netplay_bench(argv[2], argc > 3 ? atoi(argv[3]) : 300, argc > 4 ? atoi(argv[4]) : 50,
+            argc > 5 ? atof(argv[5]) / 100 : 0.05f);
+    }
+
+    u32 frames = argc > 2 ? atoi(argv[2]) : 3600;
+
+    if (!cart_load(argv[1])) {
+        printf("Failed to load ROM file: %s\n", argv[1]);
+        return -2;
+    }
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+
+    emu_get_context()->running = true;
+    emu_get_context()->fast_forward = true;
+
+    if (argc > 3 && !strcmp(argv[2], "--movie")) {
+        return replay_movie(argv[3]);
+    }
+
+    //warm up, get past the boot/intro frames.
+    run_frames(60, 1, false);
+
+    double base_fps = 0;
+
+    printf("\n%-8s %10s %10s %8s\n", "skip", "frames", "fps", "gain");
+
+    for (int i=0; i<(int)(sizeof(skip_ratios) / sizeof(skip_ratios[0])); i++) {
+        double start = now();
+        run_frames(frames, skip_ratios[i], false);
+        double fps = frames / (now() - start);
+
+        if (i == 0) {
+            base_fps = fps;
+        }
+
+        printf("1/%-6d %10u %10.1f %7.2fx\n", skip_ratios[i], frames, fps, fps / base_fps);
+    }
+
+    if (!rewind_init(64 * 1024 * 1024)) {
+        return -3;
+    }
+
+    double start = now();
+    run_frames(frames, 1, true);
+    double fps = frames / (now() - start);
+
+    rewind_stats stats;
+    rewind_get_stats(&stats);
+
+    printf("\nrewind   %10u %10.1f %7.2fx\n", frames, fps, fps / base_fps);
+    printf("  %u frames (%.1f s) in %u KB, %.1f KB/s, push %.1f us/frame\n",
+        stats.frames, stats.seconds, stats.bytes_used / 1024, stats.bytes_per_second / 1024,
+        stats.encode_us);
+
+    u32 stored = stats.frames;
+    start = now();
+
+    while (rewind_step_back());
+
+    double back_fps = stored / (now() - start);
+    rewind_get_stats(&stats);
+
+    printf("  step back %.1f us/frame, %.0f frames/s\n", stats.decode_us, back_fps);
+
+    rewind_free();
+
+    //committed frames per second, 60 is real time.
+    printf("\n%-8s %10s %10s %8s\n", "ahead", "frames", "fps", "speed");
+
+    for (int n=1; n<=RUNAHEAD_MAX_FRAMES; n++) {
+        runahead_set_frames(n);
+
+        ppu_context *ppu = ppu_get_context();
+        u32 committed = 0;
+        u32 prev_frame = ppu->current_frame;
+
+        start = now();
+
+        while (committed < frames) {
+            if (!cpu_step()) {
+                printf("CPU Stopped\n");
+                exit(-1);
+            }
+
+            if (prev_frame != ppu->current_frame) {
+                runahead_speculate();
+                prev_frame = ppu->current_frame;
+                committed++;
+            }
+        }
+
+        fps = frames / (now() - start);
+        printf("%-8d %10u %10.1f %7.2fx\n", n, frames, fps, fps / 60);
+    }
+
+    runahead_set_frames(0);
+    runahead_free();
+
+    //all machines together, one step is 4 frames.
+    printf("\n%-8s %10s %10s %10s\n", "vecenv", "envs", "frames", "fps");
+
+    static const u16 ram_addresses[16] = {
+        0xC000, 0xC001, 0xC002, 0xC003, 0xC100, 0xC101, 0xC102, 0xC103,
+        0xD000, 0xD001, 0xD002, 0xD003, 0xFF80, 0xFF81, 0xFF82, 0xFF83
+    };
+
+    for (int i=0; i<2; i++) {
+        vecenv_config config = {0};
+        config.envs = 16;
+        config.obs_type = i ? VECENV_OBS_RAM : VECENV_OBS_SCREEN;
+        config.downsample = 2;
+        config.ram_addresses = ram_addresses;
+        config.ram_count = 16;
+
+        vecenv *env = vecenv_new(argv[1], &config);
+
+        if (!env) {
+            return -5;
+        }
+
+        u8 *obs = malloc(config.envs * vecenv_obs_size(env));
+        u8 actions[16];
+        u8 done[16];
+        int steps = frames / 4 > 1 ? frames / 4 : 1;
+
+        vecenv_reset(env, obs);
+        start = now();
+
+        for (int s=0; s<steps; s++) {
+            for (int e=0; e<config.envs; e++) {
+                actions[e] = (s / 8 + e) & 1 ? GAMEPAD_A : GAMEPAD_RIGHT;
+            }
+
+            vecenv_step(env, actions, 4, obs, done);
+        }
+
+        fps = (double)steps * 4 * config.envs / (now() - start);
+        printf("%-8s %10d %10d %10.1f\n", i ? "ram" : "screen/2", config.envs,
+            steps * 4 * config.envs, fps);
+
+        free(obs);
+        vecenv_free(env);
+    }
+
+    return 0;
+}
@@ -0,0 +1,496 @@
+#include <machine.h>
+#include <state.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+    Batch runner, runs every job of a manifest headless on a pool of worker
+    threads, each job on its own machine, and streams one JSON object per
+    finished job:
+
+        {"job":0,"rom":"a.gb","movie":null,"frames":3600,"fps":2400.5,
+         "final_hash":"...","desyncs":0,"checkpoints":[{"frame":600,
+         "state":"...","screen":"..."}, ...]}
+
+    Manifest, one job per line, # starts a comment:
+
+        <rom file> [frames] [movie file]
+
+    Without a movie the job runs the given frames (3600 by default) with no
+    input. With a movie it starts from the movie's state and runs until the
+    movie ends, or for the given frames if that is less (0 = whole movie).
+    Only the checkpoint frames are rendered.
+
+    Jobs are dealt round robin to one queue per worker, a worker that runs
+    out of jobs steals from the back of the other queues.
+
+    usage: gbemu-farm <manifest> [options]
+        --out=<file>         results file, stdout by default.
+        --threads=<n>        workers, one per core by default.
+        --checkpoint=<n>     frames between checkpoints, 600 by default.
+        --scaling            run the manifest with 1, 2, 4... threads up to
+                             the worker count and print the speedup.
+ */
+
+#define DEFAULT_FRAMES 3600
+#define MAX_CHECKPOINTS 1024
+
+typedef struct {
+    char *rom;
+    char *movie;
+    u32 frames;
+} farm_job;
+
+typedef struct {
+    u32 frame;
+    u64 state;
+    u64 screen;
+} checkpoint;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int *jobs;
+    int head; //the owner takes from the head.
+    int tail; //thieves take from the tail.
+} job_queue;
+
+typedef struct {
+    farm_job *jobs;
+    int job_count;
+
+    job_queue *queues;
+    int threads;
+
+    u32 checkpoint_interval;
+
+    FILE *out;
+    pthread_mutex_t out_lock;
+
+    u64 total_frames;
+    int failed;
+} farm_context;
+
+static farm_context ctx;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static u64 screen_hash() {
+    u32 *video = ppu_get_context()->video_buffer;
+    u64 hash = 0xCBF29CE484222325ULL;
+
+    for (int i=0; i<XRES * YRES; i++) {
+        hash = (hash ^ video[i]) * 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static char *skip_space(char *s) {
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+
+    return s;
+}
+
+static char *next_token(char **s) {
+    char *start = skip_space(*s);
+
+    if (!*start || *start == '#') {
+        return NULL;
+    }
+
+    char *end = start;
+
+    while (*end && *end != ' ' && *end != '\t') {
+        end++;
+    }
+
+    *s = *end ? end + 1 : end;
+    *end = 0;
+
+    return start;
+}
+
+static bool is_number(char *s) {
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool load_manifest(char *filename) {
+    FILE *fp = fopen(filename, "r");
+
+    if (!fp) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", filename);
+        return false;
+    }
+
+    char line[4096];
+    int capacity = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\r\n")] = 0;
+
+        char *s = line;
+        char *rom = next_token(&s);
+
+        if (!rom) {
+            continue;
+        }
+
+        farm_job job = { strdup(rom), NULL, DEFAULT_FRAMES };
+        char *arg = next_token(&s);
+        bool frames_given = false;
+
+        if (arg && is_number(arg)) {
+            job.frames = atoi(arg);
+            frames_given = true;
+            arg = next_token(&s);
+        }
+
+        if (arg) {
+            job.movie = strdup(arg);
+
+            if (!frames_given) {
+                job.frames = 0;
+            }
+        }
+
+        if (ctx.job_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ctx.jobs = realloc(ctx.jobs, capacity * sizeof(farm_job));
+        }
+
+        ctx.jobs[ctx.job_count++] = job;
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static void deal_jobs() {
+    for (int t=0; t<ctx.threads; t++) {
+        job_queue *q = &ctx.queues[t];
+        q->head = q->tail = 0;
+    }
+
+    for (int i=0; i<ctx.job_count; i++) {
+        job_queue *q = &ctx.queues[i % ctx.threads];
+        q->jobs[q->tail++] = i;
+    }
+}
+
+static int take_job(int worker) {
+    job_queue *own = &ctx.queues[worker];
+
+    pthread_mutex_lock(&own->lock);
+    int job = own->head < own->tail ? own->jobs[own->head++] : -1;
+    pthread_mutex_unlock(&own->lock);
+
+    //steal from the back of the others, starting with the next worker.
+    for (int i=1; i<ctx.threads && job < 0; i++) {
+        job_queue *q = &ctx.queues[(worker + i) % ctx.threads];
+
+        pthread_mutex_lock(&q->lock);
+
+        if (q->head < q->tail) {
+            job = q->jobs[--q->tail];
+        }
+
+        pthread_mutex_unlock(&q->lock);
+    }
+
+    return job;
+}
+
+static void put_string(FILE *fp, const char *s) {
+    if (!s) {
+        fputs("null", fp);
+        return;
+    }
+
+    fputc('"', fp);
+
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', fp);
+            fputc(*s, fp);
+        } else if ((u8)*s < 0x20) {
+            fprintf(fp, "\\u%04x", (u8)*s);
+        } else {
+            fputc(*s, fp);
+        }
+    }
+
+    fputc('"', fp);
+}
+
+static void report(int index, const char *error, u32 frames, double fps, u64 final_hash,
+    u32 desyncs, checkpoint *checkpoints, int checkpoint_count) {
+
+    farm_job *job = &ctx.jobs[index];
+
+    pthread_mutex_lock(&ctx.out_lock);
+
+    ctx.total_frames += frames;
+
+    if (error) {
+        ctx.failed++;
+    }
+
+    if (!ctx.out) {
+        pthread_mutex_unlock(&ctx.out_lock);
+        return;
+    }
+
+    fprintf(ctx.out, "{\"job\":%d,\"rom\":", index);
+    put_string(ctx.out, job->rom);
+    fprintf(ctx.out, ",\"movie\":");
+    put_string(ctx.out, job->movie);
+
+    if (error) {
+        fprintf(ctx.out, ",\"error\":");
+        put_string(ctx.out, error);
+        fprintf(ctx.out, "}\n");
+    } else {
+        fprintf(ctx.out, ",\"frames\":%u,\"fps\":%.1f,\"final_hash\":\"%016llx\",\"desyncs\":%u,\"checkpoints\":[",
+            frames, fps, (unsigned long long)final_hash, desyncs);
+
+        for (int i=0; i<checkpoint_count; i++) {
+            fprintf(ctx.out, "%s{\"frame\":%u,\"state\":\"%016llx\",\"screen\":\"%016llx\"}",
+                i ? "," : "", checkpoints[i].frame,
+                (unsigned long long)checkpoints[i].state, (unsigned long long)checkpoints[i].screen);
+        }
+
+        fprintf(ctx.out, "]}\n");
+    }
+
+    fflush(ctx.out);
+    pthread_mutex_unlock(&ctx.out_lock);
+}
+
+static void run_job(int index, checkpoint *checkpoints) {
+    farm_job *job = &ctx.jobs[index];
+    machine *m = machine_new();
+
+    if (!m) {
+        report(index, "out of memory", 0, 0, 0, 0, NULL, 0);
+        return;
+    }
+
+    machine_bind(m);
+
+    if (!cart_load(job->rom)) {
+        report(index, "failed to load rom", 0, 0, 0, 0, NULL, 0);
+        machine_free(m);
+        return;
+    }
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+
+    emu_get_context()->running = true;
+    emu_get_context()->fast_forward = true;
+
+    if (job->movie && !movie_play_start(job->movie)) {
+        report(index, "failed to load movie", 0, 0, 0, 0, NULL, 0);
+        machine_free(m);
+        return;
+    }
+
+    ppu_context *ppu = ppu_get_context();
+    u32 interval = ctx.checkpoint_interval;
+    u32 frames = job->frames;
+
+    if (job->movie && (!frames || frames > movie_get_frames())) {
+        frames = movie_get_frames();
+    }
+
+    u32 prev_frame = ppu->current_frame;
+    u32 frame = 0;
+    int checkpoint_count = 0;
+    const char *error = NULL;
+
+    //pixels are only generated for the frames before a checkpoint.
+    ppu_set_frame_render(interval == 1);
+
+    double start = now();
+
+    while (frame < frames) {
+        if (!cpu_step()) {
+            error = "cpu stopped";
+            break;
+        }
+
+        if (prev_frame == ppu->current_frame) {
+            continue;
+        }
+
+        prev_frame = ppu->current_frame;
+        frame++;
+        movie_frame();
+
+        if ((frame % interval) == 0 && checkpoint_count < MAX_CHECKPOINTS) {
+            checkpoint *c = &checkpoints[checkpoint_count++];
+            c->frame = frame;
+            c->state = state_hash();
+            c->screen = screen_hash();
+        }
+
+        ppu_set_frame_render(((frame + 1) % interval) == 0);
+    }
+
+    double fps = frame / (now() - start);
+
+    report(index, error, frame, fps, state_hash(), movie_get_desyncs(),
+        checkpoints, checkpoint_count);
+
+    movie_stop();
+    machine_free(m);
+}
+
+static void *worker_run(void *p) {
+    int worker = (int)(long)p;
+    checkpoint *checkpoints = malloc(MAX_CHECKPOINTS * sizeof(checkpoint));
+
+    for (int job = take_job(worker); job >= 0; job = take_job(worker)) {
+        run_job(job, checkpoints);
+    }
+
+    free(checkpoints);
+    return 0;
+}
+
+static double run_all(int threads) {
+    pthread_t workers[threads];
+
+    ctx.threads = threads;
+    ctx.total_frames = 0;
+    ctx.failed = 0;
+    deal_jobs();
+
+    double start = now();
+
+    for (int i=0; i<threads; i++) {
+        if (pthread_create(&workers[i], NULL, worker_run, (void *)(long)i)) {
+            fprintf(stderr, "FAILED TO START WORKER THREAD!\n");
+            exit(-3);
+        }
+    }
+
+    for (int i=0; i<threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    return now() - start;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: %s <manifest> [--out=<file>] [--threads=<n>] [--checkpoint=<n>] [--scaling]\n", argv[0]);
+        return -1;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cores > 0 ? cores : 1;
+    char *out_file = NULL;
+    bool scaling = false;
+
+    ctx.checkpoint_interval = 600;
+
+    for (int i=2; i<argc; i++) {
+        if (!strncmp(argv[i], "--out=", 6)) {
+            out_file = argv[i] + 6;
+        } else if (!strncmp(argv[i], "--threads=", 10)) {
+            threads = atoi(argv[i] + 10);
+        } else if (!strncmp(argv[i], "--checkpoint=", 13)) {
+            ctx.checkpoint_interval = atoi(argv[i] + 13);
+        } else if (!strcmp(argv[i], "--scaling")) {
+            scaling = true;
+        }
+    }
+
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    if (!ctx.checkpoint_interval) {
+        ctx.checkpoint_interval = 600;
+    }
+
+    if (!load_manifest(argv[1])) {
+        return -2;
+    }
+
+    if (threads > ctx.job_count && ctx.job_count) {
+        threads = ctx.job_count;
+    }
+
+    ctx.queues = calloc(threads, sizeof(job_queue));
+
+    for (int i=0; i<threads; i++) {
+        pthread_mutex_init(&ctx.queues[i].lock, NULL);
+        ctx.queues[i].jobs = malloc((ctx.job_count + 1) * sizeof(int));
+    }
+
+    pthread_mutex_init(&ctx.out_lock, NULL);
+    cart_set_quiet(true);
+
+    if (scaling) {
+        double base = 0;
+
+        printf("%-8s %10s %10s %8s %10s\n", "threads", "frames", "fps", "speedup", "efficiency");
+
+        for (int n=1; ; n = n * 2 < threads ? n * 2 : threads) {
+            double seconds = run_all(n);
+            double fps = ctx.total_frames / seconds;
+
+            if (n == 1) {
+                base = fps;
+            }
+
+            printf("%-8d %10llu %10.1f %7.2fx %9.0f%%\n", n, (unsigned long long)ctx.total_frames,
+                fps, fps / base, 100 * fps / base / n);
+
+            if (n == threads) {
+                break;
+            }
+        }
+
+        return 0;
+    }
+
+    ctx.out = stdout;
+
+    if (out_file && !(ctx.out = fopen(out_file, "w"))) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", out_file);
+        return -2;
+    }
+
+    double seconds = run_all(threads);
+
+    fprintf(stderr, "%d jobs, %d failed, %d threads, %llu frames in %.2f s, %.1f fps\n",
+        ctx.job_count, ctx.failed, threads, (unsigned long long)ctx.total_frames,
+        seconds, ctx.total_frames / seconds);
+
+    if (ctx.out != stdout) {
+        fclose(ctx.out);
+    }
+
+    return ctx.failed ? 1 : 0;
+}
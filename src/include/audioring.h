@@ -0,0 +1,52 @@
+#pragma once
+
+#include <common.h>
+#include <stdatomic.h>
+
+/**
+    Audio ring, interleaved s16 stereo frames from the emulation thread to
+    the audio callback.
+
+    One thread writes and one thread reads, each only moves its own index
+    and neither ever waits for the other. A write that finds the ring full
+    keeps what fits and drops the rest (an overrun, the emulation is ahead
+    of the device), a read that finds it short plays silence for the rest
+    (an underrun, the emulation is behind).
+ */
+
+typedef struct {
+    u32 underruns; //reads that got fewer frames than they wanted.
+    u32 overruns; //writes that didn't fit.
+    u64 silent_frames; //played as silence by the underruns.
+    u64 dropped_frames; //lost by the overruns.
+} audio_ring_stats;
+
+typedef struct {
+    s16 *samples;
+    u32 size; //frames, a power of two.
+
+    //frames ever written and read, each moved by its own side only.
+    atomic_uint head;
+    atomic_uint tail;
+
+    //each counted by the side that sees it.
+    atomic_uint underruns;
+    atomic_uint overruns;
+    atomic_ullong silent_frames;
+    atomic_ullong dropped_frames;
+} audio_ring;
+
+//holds at least the given frames.
+bool audio_ring_init(audio_ring *ring, u32 frames);
+void audio_ring_free(audio_ring *ring);
+
+//the producer's side, returns the frames that fit.
+u32 audio_ring_write(audio_ring *ring, const s16 *samples, u32 frames);
+
+//the consumer's side, always fills all frames.
+void audio_ring_read(audio_ring *ring, s16 *samples, u32 frames);
+
+//frames written and not read yet, from either side.
+u32 audio_ring_fill(audio_ring *ring);
+
+void audio_ring_get_stats(audio_ring *ring, audio_ring_stats *stats);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <common.h>
+#include <cart.h>
+#include <pthread.h>
+
+/**
+    Write-behind battery saves.
+
+    Writes to battery backed cart ram mark 256 byte blocks dirty in the
+    cart. Once per frame the emulation thread copies the dirty blocks of
+    all ram banks into a shadow buffer and hands them to a flusher thread,
+    which waits a little to coalesce more writes and then writes only the
+    dirty ranges into the .battery file with pwrite. The emulation thread
+    never touches the file and never waits for the flusher, a block that
+    can't be handed over is taken on a later frame.
+
+    Carts with a clock keep it in a trailer after the ram, saved when the
+    game sets the clock and when saving stops.
+
+    The file stays complete at all times, a crash loses at most the writes
+    of the last coalescing interval. The sync policy decides when the
+    file is also forced to disk.
+
+    Every machine saves its own cart, the flusher thread works on the
+    context of the machine that started it.
+ */
+
+typedef enum {
+    BATTERY_SYNC_NEVER, //left to the os.
+    BATTERY_SYNC_EXIT, //once, when saving stops.
+    BATTERY_SYNC_ALWAYS //after every flush.
+} battery_sync;
+
+typedef struct {
+    u32 flushes;
+    u32 writes; //pwrite calls, one per range of adjacent dirty blocks.
+    u32 bytes;
+    u32 syncs;
+    u32 errors;
+} battery_stats;
+
+typedef struct {
+    bool active;
+    battery_sync sync;
+    int fd;
+    cart_context *cart;
+    u32 ram_size; //the rtc trailer follows the ram.
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool stop;
+
+    //filled by the emulation thread, taken by the flusher, under lock.
+    u8 *shadow;
+    u32 pending[CART_DIRTY_WORDS];
+    u8 trailer[RTC_TRAILER_SIZE];
+    bool trailer_pending;
+
+    //the flusher's own copy, written without the lock.
+    u8 *out;
+    u8 out_trailer[RTC_TRAILER_SIZE];
+
+    battery_stats stats; //under lock while the flusher runs.
+} battery_context;
+
+battery_context *battery_get_context();
+void battery_set_context(battery_context *context);
+
+//for the current cart, does nothing if it has no battery.
+bool battery_start(battery_sync sync);
+
+//writes what is left, syncs as the policy says and stops the flusher.
+void battery_stop();
+bool battery_active();
+
+//call once per frame, between two cpu steps.
+void battery_frame();
+
+void battery_get_stats(battery_stats *stats);
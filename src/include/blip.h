@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Band-limited step buffer.
+
+    A waveform is described by its changes: each change of amplitude is
+    added as a delta at its time in clocks. The delta is spread over the
+    following output samples as the difference of a band-limited step, so
+    reading the buffer back integrates to the waveform without the
+    aliasing of point sampling. The cost is per change, not per output
+    sample, and the clock and output rates are independent.
+
+    Times are clocks since the start of the current frame. Ending a frame
+    makes the samples before its end readable and starts the next frame
+    there. Reading removes the low frequencies below about 20 Hz, the
+    game boy's output has a large offset that the hardware's capacitors
+    remove as well.
+ */
+
+//output samples a step is spread over, the output lags this many.
+#define BLIP_TAPS 16
+
+typedef struct {
+    s32 *deltas; //size + BLIP_TAPS
+    u32 size;
+
+    //output samples per clock and the current frame's start, 32.32 fixed point.
+    u64 factor;
+    u64 offset;
+    u32 avail;
+
+    s32 integrator;
+    s32 dc; //the offset being removed, 24.8 fixed point.
+} blip_buffer;
+
+//holds up to the given samples between two reads.
+bool blip_init(blip_buffer *b, u32 samples);
+void blip_free(blip_buffer *b);
+
+void blip_set_rates(blip_buffer *b, double clock_rate, double sample_rate);
+void blip_clear(blip_buffer *b);
+
+//deltas of the amplitude, about +-16384 for a full scale wave.
+void blip_add_delta(blip_buffer *b, u32 time, int delta);
+
+//the frame ends at time, returns the samples that can be read.
+u32 blip_end_frame(blip_buffer *b, u32 time);
+
+//up to count samples, every stride elements of out. Returns the samples read.
+u32 blip_read_s16(blip_buffer *b, s16 *out, u32 count, int stride);
+u32 blip_read_float(blip_buffer *b, float *out, u32 count, int stride);
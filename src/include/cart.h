@@ -1,6 +1,18 @@
 #pragma once
 
 #include <common.h>
+#include <page.h>
+#include <rom.h>
+#include <mbc.h>
+
+#define CART_RAM_BANK_SIZE 0x2000
+#define CART_RAM_BANKS 16
+#define CART_RAM_BANK_PAGES PAGE_COUNT(CART_RAM_BANK_SIZE)
+#define CART_RAM_SIZE (CART_RAM_BANKS * CART_RAM_BANK_SIZE)
+
+//battery ram writes are tracked in blocks of 256 bytes, see battery.h.
+#define CART_DIRTY_SHIFT 8
+#define CART_DIRTY_WORDS ((CART_RAM_SIZE >> CART_DIRTY_SHIFT) / 32)
 
 typedef struct {
     /**
@@ -137,38 +149,67 @@ typedef struct {
     u16 global_checksum;
 } rom_header;
 
+typedef struct {
+    u64 time; //clock in emulated ticks, as of ticks.
+    u64 ticks; //emu ticks when time was taken.
+    bool halted;
+    bool carry; //the day counter overflowed.
+    u8 latch; //last write to 6000-7FFF, 0 then 1 latches the clock.
+    u8 regs[5]; //latched seconds, minutes, hours, day low, day high.
+} cart_rtc;
+
 typedef struct {
     char filename[1024];
+    rom_image *rom; //shared with every machine running the same rom.
     u32 rom_size;
-    u8 *rom_data;
-    rom_header *header;
+    const u8 *rom_data;
+    const rom_header *header;
+    char title[0x10]; //15 characters, the last byte is the cgb flag.
+    u16 rom_banks;
+    bool cgb; //the header's cgb flag is set, the game runs in color mode.
 
-    //mbc1 related data
+    const cart_mapper *mapper;
+
+    //mbc related data
     bool ram_enabled;
     bool ram_banking;
 
-    u8 *rom_bank_x;
+    const u8 *rom_bank_0; //0000-3FFF
+    const u8 *rom_bank_x; //4000-7FFF
     u8 banking_mode;
 
-    u8 rom_bank_value;
+    u16 rom_bank_value;
     u8 ram_bank_value;
 
-    u8 *ram_bank; //current selected ram bank
-    u8 *ram_banks[16]; //all ram banks
+    mem_page **ram_bank; //pages of the selected ram bank, NULL if none.
+    mem_page **ram_map; //what A000-BFFF reads, NULL goes through the mapper.
+    u8 ram_bank_count;
+
+    //all ram banks, copy on write, see page.h.
+    mem_page *ram_pages[CART_RAM_BANKS * CART_RAM_BANK_PAGES];
 
     //for battery
     bool battery; //has battery
     bool need_save; //should save battery backup.
+    u32 ram_dirty[CART_DIRTY_WORDS]; //blocks written since battery_frame took them.
+
+    bool has_rtc;
+    bool rtc_dirty; //the game set the clock, the trailer is saved again.
+    cart_rtc rtc;
 
     //battery
-    u8 ext_ram[(size_t)(128) * 1024];
+    u8 *ext_ram; //all banks, allocated by cart_save_ext_ram.
     u32 ext_ram_size;
 } cart_context;
 
 cart_context *cart_get_context();
+void cart_set_context(cart_context *context);
 
+//the rom data is copied, or shared with a machine that runs the same rom.
 bool cart_init(void* rom_data, size_t rom_size);
 bool cart_load(char *cart);
+void cart_unload();
+void cart_set_quiet(bool quiet);
 
 u8 cart_read(u16 address);
 void cart_write(u16 address, u8 value);
@@ -176,5 +217,11 @@ void cart_write(u16 address, u8 value);
 void cart_battery_load();
 void cart_battery_save();
 bool cart_need_save();
+bool cart_cgb();
+mem_page **cart_ram_bank(int bank); //NULL if the cart doesn't have it.
+u32 cart_ram_size(); //bytes in all ram banks.
+u32 cart_battery_size(); //bytes in the .battery file, ram and rtc trailer.
+void cart_map_ram(); //after the ram registers changed from outside.
+void cart_mark_dirty(u32 offset, u32 size); //offset into all ram banks.
 void cart_save_ext_ram();
 void cart_load_ext_ram();
@@ -9,6 +9,8 @@ typedef uint8_t u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t u64;
+typedef int16_t s16;
+typedef int32_t s32;
 
 void delay(u32 ms);
 u64 get_ticks();
@@ -45,24 +47,24 @@ u64 get_ticks();
 #define RI_NR51 0x25
 #define RI_NR52 0x26
 
-#define R_NR10 ctx.snd_mem[(RI_NR10)]
-#define R_NR11 ctx.snd_mem[(RI_NR11)]
-#define R_NR12 ctx.snd_mem[(RI_NR12)]
-#define R_NR13 ctx.snd_mem[(RI_NR13)]
-#define R_NR14 ctx.snd_mem[(RI_NR14)]
-#define R_NR21 ctx.snd_mem[(RI_NR21)]
-#define R_NR22 ctx.snd_mem[(RI_NR22)]
-#define R_NR23 ctx.snd_mem[(RI_NR23)]
-#define R_NR24 ctx.snd_mem[(RI_NR24)]
-#define R_NR30 ctx.snd_mem[(RI_NR30)]
-#define R_NR31 ctx.snd_mem[(RI_NR31)]
-#define R_NR32 ctx.snd_mem[(RI_NR32)]
-#define R_NR33 ctx.snd_mem[(RI_NR33)]
-#define R_NR34 ctx.snd_mem[(RI_NR34)]
-#define R_NR41 ctx.snd_mem[(RI_NR41)]
-#define R_NR42 ctx.snd_mem[(RI_NR42)]
-#define R_NR43 ctx.snd_mem[(RI_NR43)]
-#define R_NR44 ctx.snd_mem[(RI_NR44)]
-#define R_NR50 ctx.snd_mem[(RI_NR50)]
-#define R_NR51 ctx.snd_mem[(RI_NR51)]
-#define R_NR52 ctx.snd_mem[(RI_NR52)]
\ No newline at end of file
+#define R_NR10 ctx->snd_mem[(RI_NR10)]
+#define R_NR11 ctx->snd_mem[(RI_NR11)]
+#define R_NR12 ctx->snd_mem[(RI_NR12)]
+#define R_NR13 ctx->snd_mem[(RI_NR13)]
+#define R_NR14 ctx->snd_mem[(RI_NR14)]
+#define R_NR21 ctx->snd_mem[(RI_NR21)]
+#define R_NR22 ctx->snd_mem[(RI_NR22)]
+#define R_NR23 ctx->snd_mem[(RI_NR23)]
+#define R_NR24 ctx->snd_mem[(RI_NR24)]
+#define R_NR30 ctx->snd_mem[(RI_NR30)]
+#define R_NR31 ctx->snd_mem[(RI_NR31)]
+#define R_NR32 ctx->snd_mem[(RI_NR32)]
+#define R_NR33 ctx->snd_mem[(RI_NR33)]
+#define R_NR34 ctx->snd_mem[(RI_NR34)]
+#define R_NR41 ctx->snd_mem[(RI_NR41)]
+#define R_NR42 ctx->snd_mem[(RI_NR42)]
+#define R_NR43 ctx->snd_mem[(RI_NR43)]
+#define R_NR44 ctx->snd_mem[(RI_NR44)]
+#define R_NR50 ctx->snd_mem[(RI_NR50)]
+#define R_NR51 ctx->snd_mem[(RI_NR51)]
+#define R_NR52 ctx->snd_mem[(RI_NR52)]
\ No newline at end of file
@@ -67,10 +67,15 @@ typedef struct {
     bool enabling_ime;
     u8 ie_register;
     u8 int_flags;
+
+    //FF4D - KEY1, cgb only. STOP switches speed once it is armed.
+    bool speed_armed;
+    bool double_speed;
     
 } cpu_context;
 
 cpu_context *cpu_get_context();
+void cpu_set_context(cpu_context *context);
 void cpu_init();
 bool cpu_step();
 u16 cpu_read_reg(reg_type rt);
@@ -85,6 +90,8 @@ u8 cpu_read_reg8(reg_type rt);
 void cpu_set_reg8(reg_type rt, u8 val);
 u8 cpu_get_int_flags();
 void cpu_set_int_flags(u8 value);
+u8 cpu_key1_read();
+void cpu_key1_write(u8 value);
 void cpu_set_flags(cpu_context *ctx, int8_t z, int8_t n, int8_t h, int8_t c);
 
 void inst_to_str(cpu_context *ctx, char *str);
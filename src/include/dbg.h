@@ -1,8 +0,0 @@
-#pragma once
-
-#include <common.h>
-#include <cpu.h>
-
-void dbg_update();
-void dbg_print();
-
@@ -2,7 +2,60 @@
 
 #include <common.h>
 
-void dma_start(u8 start);
-void dma_tick();
+/**
+    Transfers.
+
+    OAM DMA (FF46) copies 160 bytes into oam, VRAM DMA (FF51-FF55, cgb
+    only) 16 to 2048 bytes into the selected vram bank. Nothing is copied
+    byte by byte or polled on every cycle:
+
+    - OAM DMA copies everything when it starts. The cpu can only reach hram
+      while it runs, so it can't tell, the bus just stays blocked for the
+      cycles the transfer takes, counted with the emulator's cycles.
+    - General DMA copies everything at once and stalls the cpu for as long
+      as the transfer takes.
+    - HBlank DMA copies 16 bytes when the ppu enters hblank, and stalls the
+      cpu for that block.
+
+    The cpu takes the stall before its next instruction.
+ */
+
+//2 cycles of setup, then a byte per cycle.
+#define DMA_OAM_CYCLES 162
+
+typedef struct {
+    //OAM DMA, byte and start_delay are as of the last dma_sync.
+    bool active;
+    u8 byte;
+    u8 value;
+    u8 start_delay;
+    u64 start; //emulator cycle the transfer started on.
+
+    //VRAM DMA
+    u16 vram_src; //FF51-FF52
+    u16 vram_dst; //FF53-FF54, offset into the vram bank.
+    u8 vram_blocks; //16 byte blocks left, minus 1, what FF55 reads.
+    bool hblank_active;
+    u16 stall; //cycles the cpu still has to wait for a transfer.
+} dma_context;
 
+dma_context *dma_get_context();
+void dma_set_context(dma_context *context);
+
+void dma_start(u8 start);
 bool dma_transferring();
+
+//brings byte and start_delay up to date, for save states.
+void dma_sync();
+
+//after byte, start_delay and value were loaded, finishes the copy.
+void dma_restore();
+
+u8 dma_vram_read(u16 address);
+void dma_vram_write(u16 address, u8 value);
+
+//the ppu entered hblank.
+void dma_hblank();
+
+//cycles the cpu has to wait, the stall is cleared.
+u16 dma_take_stall();
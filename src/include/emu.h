@@ -1,17 +1,30 @@
 #pragma once
 
 #include <common.h>
+#include <scheduler.h>
 
 typedef struct {
     bool paused;
     bool running;
     bool die;
+    bool fast_forward; //don't wait for the frame time, run as fast as possible.
+    bool save_state; //requested by the ui, handled between two cpu steps.
+    bool load_state;
+    bool rewinding; //held by the ui, steps back one frame per frame.
     u64 ticks;
+    u64 cycles; //cpu cycles, the transfers are timed with them, see dma.h.
+
+    //deadlines in cpu cycles, 0 when not pending, see scheduler.h.
+    u64 events[SCHED_EVENTS];
+    u64 next_event;
 } emu_context;
 
+extern u32 fps;
+
 int emu_run(int argc, char **argv);
 
 emu_context *emu_get_context();
+void emu_set_context(emu_context *context);
 
 void emu_cycles(int cpu_cycles);
 
@@ -13,17 +13,39 @@ typedef struct {
     bool right;
 } gamepad_state;
 
+//one bit per button, the layout of movies and vecenv actions.
+#define GAMEPAD_A       (1 << 0)
+#define GAMEPAD_B       (1 << 1)
+#define GAMEPAD_SELECT  (1 << 2)
+#define GAMEPAD_START   (1 << 3)
+#define GAMEPAD_RIGHT   (1 << 4)
+#define GAMEPAD_LEFT    (1 << 5)
+#define GAMEPAD_UP      (1 << 6)
+#define GAMEPAD_DOWN    (1 << 7)
+
 typedef struct {
     bool button_sel;
     bool dir_sel;
-    gamepad_state controller;
+    gamepad_state controller; //what the game reads.
+
+    //while latched the frontend writes to input and the controller is only
+    //changed on frame boundaries (movies), otherwise it writes the controller.
+    bool latched;
+    gamepad_state input;
 } gamepad_context;
 
 gamepad_context *gamepad_get_context();
+void gamepad_set_context(gamepad_context *context);
 void gamepad_init();
 bool gamepad_button_sel();
 bool gamepad_dir_sel();
 void gamepad_set_sel(u8 value);
 
+//the state the frontend updates.
 gamepad_state *gamepad_get_state();
+void gamepad_set_latched(bool latched);
+
+u8 gamepad_pack(gamepad_state *state);
+void gamepad_unpack(u8 buttons, gamepad_state *state);
+
 u8 gamepad_get_output();
@@ -2,5 +2,25 @@
 
 #include <common.h>
 
+#define IO_REGISTERS 0x80
+
+//accesses to FF00-FF7F that no register answers, per register.
+typedef struct {
+    u32 unmapped_reads[IO_REGISTERS];
+    u32 unmapped_writes[IO_REGISTERS];
+} io_stats;
+
+typedef struct {
+    io_stats stats;
+} io_context;
+
+io_context *io_get_context();
+void io_set_context(io_context *context);
+
 u8 io_read(u16 address);
 void io_write(u16 address, u8 value);
+
+//instrumentation, the counters of the bound machine.
+const io_stats *io_get_stats();
+void io_reset_stats();
+u32 io_unmapped_total(); //reads and writes.
@@ -21,6 +21,16 @@ typedef struct {
     u32 sp1_colors[4];
     u32 sp2_colors[4];
 
+    //cgb registers, only used in color mode.
+    bool cgb;
+    u8 vbk; //FF4F, vram bank of the cpu.
+    u8 bcps; //FF68, bg palette index and auto increment.
+    u8 ocps; //FF6A, obj palette index and auto increment.
+    u8 bg_palette_ram[64]; //8 palettes of 4 15 bit colors, FF69.
+    u8 obj_palette_ram[64]; //FF6B.
+    u32 bg_cgb_colors[8][4];
+    u32 sp_cgb_colors[8][4];
+
 } lcd_context;
 
 typedef enum {
@@ -31,6 +41,7 @@ typedef enum {
 } lcd_mode;
 
 lcd_context *lcd_get_context();
+void lcd_set_context(lcd_context *context);
 
 /**
   FF41 - STAT - LCDC Status   (R/W)
@@ -93,7 +104,23 @@ typedef enum {
 
 #define LCDS_STAT_INT(src) (lcd_get_context()->lcds & src)
 
+/**
+  FF68 - BCPS/BGPI - Background Palette Index (CGB Mode Only)
+    Bit 7   - Auto Increment  (0=Disabled, 1=Increment after Writing)
+    Bit 5-0 - Index (00-3F)
+
+  FF69 - BCPD/BGPD - Background Palette Data (CGB Mode Only)
+    Two bytes per color, little endian.
+    Bit 0-4   Red Intensity   (00-1F)
+    Bit 5-9   Green Intensity (00-1F)
+    Bit 10-14 Blue Intensity  (00-1F)
+
+  FF6A - OCPS/OBPI, FF6B - OCPD/OBPD work the same for the sprite palettes.
+  Color 0 of the sprite palettes is transparent.
+ */
+
 void lcd_init();
+void lcd_update_cgb_colors(); //after the palette ram was loaded.
 
 u8 lcd_read(u16 address);
 void lcd_write(u16 address, u8 value);
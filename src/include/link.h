@@ -0,0 +1,67 @@
+#pragma once
+
+#include <common.h>
+#include <machine.h>
+
+/**
+    Link cable, two games playing against each other over the serial port.
+
+    In process both machines are run in lockstep, a quantum of emulated
+    time at a time, on one thread or on a thread each with a barrier at the
+    end of every quantum. A game finishing an internal clock transfer gets
+    the byte its partner had in SB at the last barrier, the partner gets
+    its byte at the next one. A transfer takes 4096 ticks, a quantum of one
+    scanline leaves the partner plenty of time to get ready for the next.
+
+    Between processes the cable is a unix domain socket and the two sides
+    only talk at transfer boundaries. The side that clocks a transfer
+    doesn't wait for the answer: it goes on with the byte the partner last
+    announced, saves the state and sends its own byte. If the answer turns
+    out different the state is loaded again with the right byte and the
+    time since is run again. At most one transfer is in flight, the next
+    one waits for the answer of the previous.
+ */
+
+//ticks of emulated time between two barriers of the in-process cable.
+#define LINK_QUANTUM 456
+
+//ticks between two reads of the socket.
+#define LINK_POLL_TICKS 456
+
+typedef struct link_cable link_cable;
+
+typedef struct {
+    u32 transfers; //bytes clocked by either side.
+    u32 speculations; //answers that were predicted.
+    u32 rollbacks; //predictions that were wrong.
+    u64 rollback_ticks; //emulated time that was run again.
+    u32 stalls; //transfers that waited for the previous answer.
+} link_stats;
+
+//an in-process cable, threads is 1 or 2.
+link_cable *link_local(machine *a, machine *b, int threads);
+
+//runs both machines for the given ticks, false once a cpu stopped. The
+//calling thread is left bound to machine a.
+bool link_run(link_cable *l, u32 ticks);
+
+//the quanta start again from the machines' current time, after their
+//states were loaded. Runs that restart at the same states run the same.
+void link_restart(link_cable *l);
+
+//the bound machine's end of a cable between processes, listening waits
+//for the other process to connect.
+link_cable *link_listen(const char *path);
+link_cable *link_connect(const char *path);
+
+//an already connected stream socket, e.g. one end of a socketpair.
+link_cable *link_socket(int fd);
+
+//between two cpu steps of the bound machine, false once the other side
+//went away.
+bool link_poll(link_cable *l);
+
+void link_get_stats(link_cable *l, link_stats *stats);
+
+//unplugs the cable, the machines keep running without it.
+void link_free(link_cable *l);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <common.h>
+#include <cart.h>
+#include <cpu.h>
+#include <timer.h>
+#include <dma.h>
+#include <ram.h>
+#include <gbio.h>
+#include <serial.h>
+#include <gamepad.h>
+#include <sound.h>
+#include <ppu.h>
+#include <lcd.h>
+#include <emu.h>
+#include <movie.h>
+#include <battery.h>
+#include <page.h>
+
+/**
+    Emulator instances.
+
+    Every module reaches its context through a thread local pointer. By
+    default all threads share one machine, which is what the frontends use.
+    A thread that binds a machine works on that one from then on, so a
+    process can run as many games as it has threads, each thread running
+    one machine at a time.
+
+    Rewind, run-ahead and deferred ppu rendering keep a single context and
+    are only available on the default machine.
+ */
+
+typedef struct {
+    cart_context cart;
+    cpu_context cpu;
+    timer_context timer;
+    dma_context dma;
+    ram_context ram;
+    io_context io;
+    serial_context serial;
+    gamepad_context gamepad;
+    sound_context sound;
+    ppu_context ppu;
+    lcd_context lcd;
+    emu_context emu;
+    movie_context movie;
+    battery_context battery;
+} machine;
+
+//a blank machine, bind it before calling the modules' init functions.
+machine *machine_new();
+
+/**
+    A copy of the machine that runs on from the same state, for tree
+    searches. The fork costs about the size of the machine struct, the
+    rom is shared and wram, vram and cart ram pages are only copied when
+    one of the machines writes them. The fork has no audio output and
+    renders nothing until ppu_set_frame_render turns rendering on.
+    The parent must not run while it is forked, both may run on
+    different threads afterwards.
+ */
+machine *machine_fork(machine *parent);
+
+//the calling thread works on this machine from now on.
+void machine_bind(machine *m);
+
+//also frees what the modules allocated for it, bind another machine
+//before the thread uses the modules again.
+void machine_free(machine *m);
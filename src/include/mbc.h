@@ -0,0 +1,52 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Memory bank controllers.
+
+    The cart reads rom and ram through pointers to the selected banks, a
+    bank switch only moves a pointer. Banks past the end of the rom wrap
+    around to the banks the rom has. A mapper handles the writes to its
+    registers at 0000-7FFF and the A000-BFFF accesses when no ram bank is
+    mapped there (ram disabled, rtc registers). The cartridge type byte
+    picks the mapper from a table, so adding an mbc doesn't touch the
+    common read and write path.
+
+    The mbc3 clock is not ticked, it is computed from the emulated ticks
+    only when the game latches, reads or writes it.
+ */
+
+typedef struct {
+    const char *name;
+
+    void (*map)(); //points the rom banks at what the registers select.
+    void (*write)(u16 address, u8 value); //0000-7FFF, the registers.
+    u8 (*ram_read)(u16 address); //A000-BFFF when no ram bank is mapped.
+    void (*ram_write)(u16 address, u8 value);
+
+    u8 rom_bank_bits;
+    bool ram_always; //no ram enable register.
+} cart_mapper;
+
+typedef struct {
+    const cart_mapper *mapper;
+    bool battery;
+    bool rtc;
+} cart_type_info;
+
+//unknown types run as rom only.
+const cart_type_info *mbc_type_info(u8 type);
+
+//the running clock in emulated ticks, for save states.
+u64 mbc_rtc_get_clock();
+void mbc_rtc_set_clock(u64 clock);
+
+//the current clock in the trailer format at the end of .battery files:
+//5 x u32 time (s, m, h, dl, dh), 5 x u32 latched time, u64 unix time.
+#define RTC_TRAILER_SIZE 48
+
+void mbc_rtc_save(u8 *trailer);
+
+//the clock went on for the real time since the trailer was saved.
+bool mbc_rtc_load(const u8 *trailer, u32 size);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Input movies.
+
+    A movie is a save state to start from and the joypad state for every
+    frame. While a movie is recorded or played the joypad is latched, the
+    game only sees new input on frame boundaries, so a replay goes through
+    exactly the same states as the recording. Every hash interval frames a
+    hash of the whole machine state is stored, a replay compares them to
+    find the first frame it went out of sync.
+
+    File layout (little endian):
+        "GBMV", u32 version, u64 rom hash, u32 frames, u32 hash interval,
+        u32 hash count, u32 state size, start state,
+        frames x u8 buttons (bit 0..7 = a, b, select, start, right, left,
+        up, down), hash count x u64 state hash
+ */
+
+#define MOVIE_VERSION 1
+
+typedef enum {
+    MOVIE_NONE,
+    MOVIE_RECORD,
+    MOVIE_PLAY
+} movie_mode;
+
+typedef struct {
+    movie_mode mode;
+    bool finished;
+
+    u64 rom_hash;
+    u32 hash_interval;
+
+    u8 *start_state;
+    u32 state_size;
+
+    u8 *buttons; //one byte per frame.
+    u32 frames;
+    u32 frames_capacity;
+
+    u64 *hashes; //one per hash interval.
+    u32 hash_count;
+    u32 hash_capacity;
+
+    u32 frame;
+    u32 desyncs;
+    int first_desync;
+} movie_context;
+
+//starts from the current state, call between two cpu steps.
+bool movie_record_start(u32 hash_interval);
+bool movie_save(const char *filename);
+
+//loads the movie's start state.
+bool movie_play_start(const char *filename);
+
+//call on every frame boundary, right after the frame counter changed.
+void movie_frame();
+
+//the joypad goes back to the frontend, a recording is kept until saved.
+void movie_stop();
+
+movie_mode movie_get_mode();
+bool movie_finished(); //played to the end.
+u32 movie_get_frame(); //frames since the start.
+u32 movie_get_frames(); //length of the movie.
+u32 movie_get_desyncs(); //state hashes that didn't match.
+int movie_first_desync(); //-1 when all matched so far.
+
+movie_context *movie_get_context();
+void movie_set_context(movie_context *context);
+
+u64 movie_rom_hash();
+u64 movie_state_hash();
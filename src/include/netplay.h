@@ -0,0 +1,102 @@
+#pragma once
+
+#include <common.h>
+#include <machine.h>
+
+/**
+    Rollback netplay, two players on two hosts, each with a game boy of
+    their own and a link cable in between.
+
+    Both processes run both machines on an in-process cable, only the
+    inputs go over the network. Every frame is run with the local input
+    and a prediction of the remote one, the remote's last known input,
+    and the state at the start of every frame not confirmed yet is kept.
+    When the remote input for a frame arrives and differs from what the
+    frame was run with, both machines are loaded back to that frame and
+    the frames since are run again without rendering. Runs from the same
+    states with the same inputs are the same, so both processes end up on
+    the same frames.
+
+    Inputs travel in datagrams. Every datagram repeats all inputs the
+    remote hasn't acknowledged yet, a lost one is covered by the next.
+    A side that is max_rollback frames ahead of the last input it got
+    waits for the remote instead of running.
+
+    Latency and loss can be injected on the sending side: datagrams are
+    held back for the given time and dropped at the given rate.
+ */
+
+//frames that can be rolled back, the window is chosen per session.
+#define NETPLAY_MAX_ROLLBACK 64
+
+//the default window.
+#define NETPLAY_ROLLBACK 8
+
+typedef struct netplay netplay;
+
+typedef struct {
+    //the local input drives machine a (0) or b (1).
+    int player;
+
+    //a connected datagram socket, netplay_udp or a unix socketpair.
+    int fd;
+
+    //frames a prediction may stay unconfirmed, 0 for NETPLAY_ROLLBACK.
+    u32 max_rollback;
+
+    //injected on the datagrams this side sends.
+    u32 latency_ms;
+    float loss;
+    u32 seed;
+} netplay_config;
+
+typedef struct {
+    u32 frames; //frames run for the first time.
+    u32 waits; //calls that waited for the remote instead of running.
+    u32 rollbacks;
+    u64 rollback_frames; //frames run again.
+    u32 max_depth; //the most frames one rollback ran again.
+    double rollback_ms; //time spent in rollbacks.
+    double max_rollback_ms;
+    u32 sent;
+    u32 dropped; //by the injected loss.
+    u32 received;
+} netplay_stats;
+
+/**
+    Both machines must be in the same state as on the remote, e.g. both
+    freshly booted with the same rom. They are plugged into a cable of
+    their own.
+ */
+netplay *netplay_new(machine *a, machine *b, const netplay_config *config);
+
+//a udp socket bound to the port, connected to the remote port on host
+//(e.g. "127.0.0.1"), -1 if either fails.
+int netplay_udp(u16 port, const char *host, u16 remote_port);
+
+/**
+    Runs the next frame with the local buttons (GAMEPAD_* bits), false if
+    it had to wait for the remote and nothing ran. Only the local machine
+    renders. The calling thread is left bound to the local machine.
+ */
+bool netplay_frame(netplay *np, u8 buttons);
+
+//waits until both sides have all inputs of the frames run so far, false
+//after timeout_ms. Both sides are then in the same state.
+bool netplay_flush(netplay *np, u32 timeout_ms);
+
+//loads the state of the given number of frames ago and runs the frames
+//again with the same inputs, false beyond the window. For measuring.
+bool netplay_resimulate(netplay *np, u32 frames);
+
+//frames run so far, and the ones that ran with the remote's input.
+u32 netplay_get_frame(netplay *np);
+u32 netplay_get_confirmed(netplay *np);
+
+//hash of both machines.
+u64 netplay_state_hash(netplay *np);
+
+void netplay_get_stats(netplay *np, netplay_stats *stats);
+
+//the machines stay, unplugged, and take the frontend's input again.
+void netplay_free(netplay *np);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common.h>
+#include <stdatomic.h>
+
+/**
+    Copy on write memory pages.
+
+    The writable memory that forks of a machine share (wram, vram and cart
+    ram) is kept in reference counted pages. A page is copied on the first
+    write while another machine still uses it. A NULL page reads as zeros
+    and is allocated on its first write.
+ */
+
+#define PAGE_SHIFT 10
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+//pages needed for size bytes.
+#define PAGE_COUNT(size) (((size) + PAGE_SIZE - 1) >> PAGE_SHIFT)
+
+typedef struct {
+    atomic_int refs;
+    u8 data[PAGE_SIZE];
+} mem_page;
+
+//makes the page in slot private to the caller, copying it if it is shared.
+mem_page *page_unshare(mem_page **slot);
+
+static inline u8 page_read_u8(mem_page **pages, u32 offset) {
+    mem_page *page = pages[offset >> PAGE_SHIFT];
+
+    return page ? page->data[offset & PAGE_MASK] : 0;
+}
+
+static inline void page_write_u8(mem_page **pages, u32 offset, u8 value) {
+    mem_page *page = pages[offset >> PAGE_SHIFT];
+
+    if (!page || atomic_load_explicit(&page->refs, memory_order_acquire) != 1) {
+        page = page_unshare(&pages[offset >> PAGE_SHIFT]);
+    }
+
+    page->data[offset & PAGE_MASK] = value;
+}
+
+void page_read(mem_page **pages, u32 offset, void *dst, u32 size);
+void page_write(mem_page **pages, u32 offset, const void *src, u32 size);
+
+//one more owner for every page, for a fork.
+void page_share(mem_page **pages, int count);
+
+//drops the caller's pages, the last owner frees them.
+void page_release(mem_page **pages, int count);
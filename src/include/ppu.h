@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common.h>
+#include <page.h>
 
 /**
  * 
@@ -70,7 +71,6 @@ static const int LINES_PER_FRAME = 154;
 static const int TICKS_PER_LINE = 456;
 static const int YRES = 144;
 static const int XRES = 160;
-extern u32 fps;
 
 typedef enum {
     FS_TILE,
@@ -80,15 +80,14 @@ typedef enum {
     FS_PUSH
 } fetch_state;
 
-typedef struct _fifo_entry {
-    struct _fifo_entry *next;
-    u32 value; //32 bit color value.
-} fifo_entry;
+//the fetcher only pushes while 8 or fewer pixels are queued, so the
+//fifo never holds more than 16 entries.
+#define PIXEL_FIFO_SIZE 16
 
 typedef struct {
-    fifo_entry *head;
-    fifo_entry *tail;
-    u32 size;
+    u32 entries[PIXEL_FIFO_SIZE]; //32 bit color values.
+    u8 head;
+    u8 size;
 } fifo;
 
 typedef struct {
@@ -98,6 +97,7 @@ typedef struct {
     u8 pushed_x;
     u8 fetch_x;
     u8 bgw_fetch_data[3];
+    u8 bgw_fetch_attr; //cgb bg map attributes of the fetched tile, see below.
     u8 fetch_entry_data[6]; //oam data..
     u8 map_y;
     u8 map_x;
@@ -134,9 +134,28 @@ typedef struct _oam_line_entry {
 } oam_line_entry;
 
 
+/*
+ CGB BG Map Attributes, in VRAM bank 1 at the tile's map address
+ Bit7   BG-to-OAM Priority  (0=Use OAM priority bit, 1=BG Priority)
+ Bit6   Vertical Flip       (0=Normal, 1=Mirror vertically)
+ Bit5   Horizontal Flip     (0=Normal, 1=Mirror horizontally)
+ Bit4   Not used
+ Bit3   Tile VRAM Bank number (0=Bank 0, 1=Bank 1)
+ Bit2-0 Background Palette number (BGP0-7)
+ */
+
+#define BG_ATTR_PRIORITY (1 << 7)
+#define BG_ATTR_Y_FLIP (1 << 6)
+#define BG_ATTR_X_FLIP (1 << 5)
+#define BG_ATTR_BANK (1 << 3)
+
+//one bank, what a dmg has. a cgb has two, selected by VBK.
+#define VRAM_SIZE 0x2000
+#define VRAM_CGB_SIZE 0x4000
+
 typedef struct {
     oam_entry oam_ram[40];
-    u8 vram[0x2000];
+    mem_page *vram[PAGE_COUNT(VRAM_CGB_SIZE)]; //copy on write, see page.h.
 
     pixel_fifo_context pfc;
 
@@ -150,7 +169,23 @@ typedef struct {
 
     u32 current_frame;
     u32 line_ticks;
-    u32 *video_buffer;
+    u32 *video_buffer; //NULL for forks that haven't rendered yet.
+
+    //frame skip, pixels are only generated when frame_render is set.
+    //next_frame_render is latched into frame_render when a new frame starts.
+    bool frame_render;
+    bool next_frame_render;
+
+    //deferred rendering, see ppu_deferred.h
+    bool deferred; //timing only, writes are logged for the render thread.
+    bool replay; //render thread, no interrupts or frame pacing.
+    u64 dots; //ppu ticks since init, timestamps the logged writes.
+
+    //change detection, a hash of every finished line is compared with the
+    //previous frame's and the line is stamped with the frame it changed on.
+    u32 line_hash[144];
+    u32 line_changed[144];
+    u32 changed_frame; //last frame any line changed on.
 } ppu_context;
 
 void ppu_init();
@@ -160,11 +195,31 @@ void ppu_oam_write(u16 address, u8 value);
 u8 ppu_oam_read(u16 address);
 
 void ppu_vram_write(u16 address, u8 value);
+void ppu_vram_write_block(u16 address, const u8 *data, u16 len); //within one bank.
 u8 ppu_vram_read(u16 address);
 
+//vram as the ppu sees it, independent of VBK.
+static inline u8 ppu_vram_bank_read(ppu_context *ppu, u8 bank, u16 address) {
+    return page_read_u8(ppu->vram, (address - 0x8000) + bank * VRAM_SIZE);
+}
+
 ppu_context *ppu_get_context();
+void ppu_set_context(ppu_context *context);
+
+//dst shares src's vram pages and gets its own sprite list, the video
+//buffer pointer is not copied.
+void ppu_copy_context(ppu_context *dst, ppu_context *src);
+
+void ppu_set_frame_render(bool render);
+
+void ppu_line_finished(u8 line);
+bool ppu_frame_changed(u32 since_frame, u8 *first_line, u8 *last_line);
+
+void ppu_lcd_disable();
+void ppu_lcd_enable();
 
 void pipeline_process();
+void pipeline_skip_process();
 void pipeline_fifo_reset();
 
 bool window_visible();
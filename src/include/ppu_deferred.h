@@ -0,0 +1,42 @@
+#pragma once
+
+#include <common.h>
+#include <ppu.h>
+
+/**
+    Deferred PPU rendering.
+
+    The emulation thread keeps running the ppu state machine for the mode
+    timing, LY and the interrupts, but skips the pixel pipeline. Every write
+    to vram, oam and the lcd registers is appended to a lock free log and
+    timestamped with the ppu dot it happened on. A render thread owns its
+    own copy of the ppu and lcd, replays the log at the same dots and runs
+    the full pipeline, so the frames are identical to single threaded
+    rendering, only later.
+
+    Must be started right after ppu_init, before the first ppu_tick. When
+    the main ppu is replaced from outside (loading a save state), stop the
+    thread first and restart it afterwards.
+ */
+
+typedef enum {
+    PPU_SYNC_LINE, //render thread may run up to the last completed line.
+    PPU_SYNC_FRAME //render thread may run up to the last completed frame.
+} ppu_sync;
+
+void ppu_deferred_start(ppu_sync sync);
+void ppu_deferred_stop();
+bool ppu_deferred_active();
+
+//starts again from the current main ppu with the last used sync mode.
+void ppu_deferred_restart();
+
+//the render thread's ppu, only consistent right after ppu_deferred_flush.
+ppu_context *ppu_deferred_render_context();
+
+//blocks until the render thread has caught up with the emulation thread.
+void ppu_deferred_flush();
+
+//emulation thread side, called by the ppu and lcd.
+void ppu_deferred_log(u16 address, u8 value);
+void ppu_deferred_line_end();
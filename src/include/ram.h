@@ -1,12 +1,31 @@
+#pragma once
+
 #include <common.h>
+#include <page.h>
+
+//what a dmg sees, banks 0 and 1. a cgb switches D000-DFFF between banks 1-7.
+#define WRAM_SIZE 0x2000
+#define WRAM_BANK_SIZE 0x1000
+#define WRAM_CGB_SIZE 0x8000
 
 typedef struct {
-    u8 wram[0x2000];
+    mem_page *wram[PAGE_COUNT(WRAM_CGB_SIZE)]; //copy on write, see page.h.
     u8 hram[0x80];
+
+    //FF70 - SVBK, D000-DFFF is bank svbk (0 selects 1), wram_offset
+    //bytes past bank 1.
+    u8 svbk;
+    u16 wram_offset;
 } ram_context;
 
+ram_context *ram_get_context();
+void ram_set_context(ram_context *context);
+
 u8 wram_read(u16 address);
 void wram_write(u16 address, u8 value);
 
 u8 hram_read(u16 address);
 void hram_write(u16 address, u8 value);
+
+u8 ram_svbk_read();
+void ram_svbk_write(u8 value);
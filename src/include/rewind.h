@@ -0,0 +1,42 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Rewind buffer.
+
+    A save state is taken once per frame and stored as the xor of the
+    previous frame's state, run length encoded, so frames that only touch a
+    few bytes of ram and a few lines of the screen cost a few hundred bytes.
+    The newest state is kept whole, and xor is its own inverse, so stepping
+    back one frame is a single delta applied to it followed by a state load.
+
+    The deltas live in a ring of fixed size, the oldest frames are dropped
+    when it is full.
+ */
+
+typedef struct {
+    u32 frames; //frames that can be stepped back.
+    u32 bytes_used;
+    u32 budget;
+    double seconds; //frames at 60 per second.
+    double bytes_per_second;
+    double encode_us; //average time per rewind_push.
+    double decode_us; //average time per rewind_step_back.
+} rewind_stats;
+
+//budget is the size of the delta ring in bytes.
+bool rewind_init(u32 budget);
+void rewind_free();
+bool rewind_enabled();
+
+//drops every stored frame, the next push starts a new history.
+void rewind_clear();
+
+//call once per frame, between two cpu steps.
+void rewind_push();
+
+//loads the state of the previous pushed frame, false if there is none.
+bool rewind_step_back();
+
+void rewind_get_stats(rewind_stats *stats);
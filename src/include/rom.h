@@ -0,0 +1,47 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Shared rom images.
+
+    Roms are read only, so every machine in the process that runs the same
+    game uses the same image. Rom files are mapped instead of read, opening
+    one costs the same whatever its size and only the parts the game
+    reaches are ever loaded. Images are found again by file, or by content
+    when another image of the same size exists, and freed when the last
+    machine releases them.
+ */
+
+typedef struct rom_image {
+    const u8 *data;
+    u32 size;
+
+    //content hash, computed when first needed.
+    u64 hash;
+    bool hashed;
+
+    //the file it was mapped from, 0 for images made from memory.
+    u64 dev;
+    u64 ino;
+    u64 mtime;
+    bool mapped;
+
+    int refs;
+    struct rom_image *next;
+} rom_image;
+
+//NULL if the file can't be opened or is too small to be a rom.
+rom_image *rom_open(const char *filename);
+
+//the data is copied unless an image with the same content exists.
+rom_image *rom_from_memory(const void *data, u32 size);
+
+void rom_retain(rom_image *rom);
+void rom_release(rom_image *rom);
+
+//64 bit FNV-1a of the whole image.
+u64 rom_hash(rom_image *rom);
+
+//images currently shared in the process.
+int rom_image_count();
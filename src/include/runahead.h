@@ -0,0 +1,32 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Run-ahead.
+
+    After every committed frame the machine is saved, the next frames are
+    emulated with the current input and the last one is shown, then the
+    machine is restored. The picture on screen is always a few frames
+    ahead of the committed timeline, which hides that much of the game's
+    own input lag.
+
+    The committed and hidden frames skip pixel generation, only the shown
+    frame is rendered. Audio is muted while running ahead, so samples only
+    come from the committed timeline. The frontend only paces the
+    committed frames.
+
+    Does not work together with deferred ppu rendering.
+ */
+
+#define RUNAHEAD_MAX_FRAMES 4
+
+//0 disables run-ahead.
+void runahead_set_frames(int frames);
+int runahead_get_frames();
+
+//call right after each committed frame, between two cpu steps.
+//returns false when the cpu stopped while running ahead.
+bool runahead_speculate();
+
+void runahead_free();
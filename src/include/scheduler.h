@@ -0,0 +1,28 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Events, for peripherals that finish something a known number of cpu
+    cycles after it started. emu_cycles compares the cycle counter with
+    the earliest deadline once per call and runs the events that are due,
+    nothing is polled on every cycle or instruction.
+
+    The deadlines are kept in the emu context, every machine has its own.
+ */
+
+typedef enum {
+    SCHED_SERIAL, //a serial transfer completes, see serial.h.
+    SCHED_FRAME_SEQUENCER, //the apu's 512 Hz step, see timer.h.
+    SCHED_EVENTS
+} sched_event;
+
+//runs the event the given cpu cycles from now, replacing a pending one.
+void scheduler_add(sched_event event, u32 cycles);
+void scheduler_cancel(sched_event event);
+
+//cpu cycles until the event runs, 0 if it isn't pending.
+u32 scheduler_remaining(sched_event event);
+
+//runs the due events, emu_cycles calls it once the next deadline passed.
+void scheduler_run();
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Serial port, FF01 SB and FF02 SC.
+
+    Writing SC with bit 7 set starts a transfer. With the internal clock
+    (bit 0) the eight bits are shifted at 8192 Hz, or 262144 Hz with the
+    cgb's fast clock (bit 1), so the transfer completes 1024 or 32 cpu
+    cycles later: SB is exchanged with the sink, bit 7 of SC is cleared
+    and IT_SERIAL is requested. With the external clock the other side
+    drives the transfer, without one it never completes.
+
+    The sink gets the byte that was shifted out and returns the byte that
+    was shifted in. Without a sink nothing is connected and FF comes in.
+ */
+
+//1024 cycles for the 8 bits at 8192 Hz, the cgb's fast clock is 32 times faster.
+#define SERIAL_CYCLES 1024
+#define SERIAL_FAST_CYCLES 32
+
+typedef u8 (*serial_sink)(u8 out, void *user);
+
+typedef struct {
+    u8 sb;
+    u8 sc;
+
+    serial_sink sink;
+    void *sink_user;
+} serial_context;
+
+//the bytes a game sends, test roms report their results this way.
+typedef struct {
+    char data[1024];
+    u32 size;
+} serial_capture;
+
+serial_context *serial_get_context();
+void serial_set_context(serial_context *context);
+
+u8 serial_read(u16 address);
+void serial_write(u16 address, u8 value);
+
+//NULL disconnects the port.
+void serial_set_sink(serial_sink sink, void *user);
+
+//user is a zeroed serial_capture, the data stays 0 terminated.
+u8 serial_capture_sink(u8 out, void *user);
+
+//the end of a transfer, run by the scheduler.
+void serial_complete();
+
+//a transfer waits for the other side's clock.
+bool serial_waiting();
+
+//the other side clocked in a byte, returns the byte shifted out. Only a
+//waiting transfer takes it, otherwise nothing changes and FF is returned.
+u8 serial_external(u8 in);
+
+//cycles left of a running transfer, 0 if there is none.
+u32 serial_remaining();
+
+//after SB and SC were loaded, continues a transfer that had cycles left.
+void serial_restore(u32 cycles);
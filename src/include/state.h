@@ -0,0 +1,44 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Save states.
+
+    The whole machine (cpu, ppu, lcd, timer, dma, ram, cartridge banking and
+    ram, apu, joypad select and serial registers) is written into a single
+    contiguous buffer. Nothing in the buffer is a pointer, the pixel fifo,
+    the sprite list and the selected banks are stored as values and indices,
+    so a buffer can be copied around, written to disk or kept in memory.
+
+    Layout (little endian):
+        header  : "GBST", u32 version, u32 total size,
+                  u32 rom size, u16 global checksum, u8 header checksum, u8 0
+        section : u32 id, u32 payload size, payload...
+
+    A state only loads for the rom it was saved from. Sections with an
+    unknown id are skipped and sections that are shorter than expected are
+    zero filled, so new fields are added to the end of a section or as a new
+    section without breaking older states. The version only changes when the
+    layout above changes.
+
+    Saving and loading must happen between two cpu steps.
+ */
+
+#define STATE_VERSION 1
+
+//bytes needed to save the current machine, depends on the cartridge ram.
+u32 state_size();
+
+//returns the number of bytes written, 0 if the buffer is too small.
+u32 state_save(u8 *buffer, u32 size);
+
+//the machine is only changed if the whole state is valid.
+bool state_load(const u8 *buffer, u32 size);
+
+//hash of the emulated machine, leaves out the picture and the pixel
+//pipeline so it doesn't depend on frame skipping.
+u64 state_hash();
+
+bool state_save_file(const char *filename);
+bool state_load_file(const char *filename);
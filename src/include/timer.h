@@ -12,8 +12,15 @@ typedef struct {
 void timer_init();
 void timer_tick();
 
+//the apu's frame sequencer steps when bit 12 of div falls, bit 13 at
+//double speed, so 512 Hz at either. The edges are scheduled from div
+//instead of checked on every tick.
+void timer_schedule_sequencer();
+void timer_frame_sequencer();
+
 void timer_write(u16 address, u8 value);
 u8 timer_read(u16 address);
 
 timer_context *timer_get_context();
+void timer_set_context(timer_context *context);
 
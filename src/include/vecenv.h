@@ -0,0 +1,61 @@
+#pragma once
+
+#include <common.h>
+
+/**
+    Vectorized environments, for training agents on a rom.
+
+    A vecenv holds M machines running the same rom, each on its own
+    episode. vecenv_step applies one action per machine, runs every machine
+    for the given number of frames on a pool of worker threads and writes
+    the observations and done flags of all machines into the caller's
+    buffers, machine i at offset i * vecenv_obs_size.
+
+    An action is a button mask (GAMEPAD_A ... GAMEPAD_DOWN), held for the
+    whole step. An observation is either the screen, grayscale and averaged
+    down by 1, 2 or 4 in both directions, or a list of bytes read through
+    the bus. Pixels are only generated for the last frame of a step, and not
+    at all for ram observations.
+
+    An episode is done when the cpu stops, after max_episode_frames, or when
+    the done callback says so. A done machine keeps its last observation and
+    starts a new episode from the start state at its next step.
+ */
+
+typedef struct vecenv vecenv;
+
+typedef enum {
+    VECENV_OBS_SCREEN,
+    VECENV_OBS_RAM
+} vecenv_obs_type;
+
+//called on the worker thread with the machine bound, read it through the bus.
+typedef bool (*vecenv_done_fn)(int env, u32 episode_frames, void *user);
+
+typedef struct {
+    int envs;
+    int threads; //0 = one per core.
+
+    vecenv_obs_type obs_type;
+    int downsample; //screen observations, 1, 2 or 4.
+    const u16 *ram_addresses; //ram observations.
+    int ram_count;
+
+    u32 max_episode_frames; //0 = no limit.
+    const char *state_file; //episodes start here, NULL starts at power on.
+
+    vecenv_done_fn done;
+    void *user;
+} vecenv_config;
+
+vecenv *vecenv_new(const char *rom_file, const vecenv_config *config);
+void vecenv_free(vecenv *env);
+
+int vecenv_count(vecenv *env);
+u32 vecenv_obs_size(vecenv *env); //bytes per machine.
+
+//starts a new episode on every machine.
+void vecenv_reset(vecenv *env, u8 *obs);
+
+//actions and done hold one byte per machine, obs vecenv_obs_size bytes.
+void vecenv_step(vecenv *env, const u8 *actions, int frames_per_step, u8 *obs, u8 *done);
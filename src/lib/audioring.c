@@ -0,0 +1,80 @@
+#include <audioring.h>
+#include <string.h>
+
+bool audio_ring_init(audio_ring *ring, u32 frames) {
+    u32 size = 1;
+
+    while (size < frames) {
+        size <<= 1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->samples = calloc(size * 2, sizeof(s16));
+    ring->size = size;
+
+    return ring->samples != NULL;
+}
+
+void audio_ring_free(audio_ring *ring) {
+    free(ring->samples);
+    ring->samples = NULL;
+    ring->size = 0;
+}
+
+//copies frames between the ring at index and buffer, in up to two parts.
+static void copy(audio_ring *ring, u32 index, s16 *buffer, u32 frames, bool to_ring) {
+    u32 start = index & (ring->size - 1);
+    u32 first = ring->size - start < frames ? ring->size - start : frames;
+    s16 *at = ring->samples + start * 2;
+
+    if (to_ring) {
+        memcpy(at, buffer, first * 2 * sizeof(s16));
+        memcpy(ring->samples, buffer + first * 2, (frames - first) * 2 * sizeof(s16));
+    } else {
+        memcpy(buffer, at, first * 2 * sizeof(s16));
+        memcpy(buffer + first * 2, ring->samples, (frames - first) * 2 * sizeof(s16));
+    }
+}
+
+u32 audio_ring_write(audio_ring *ring, const s16 *samples, u32 frames) {
+    u32 head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    u32 tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    u32 space = ring->size - (head - tail);
+    u32 count = frames < space ? frames : space;
+
+    copy(ring, head, (s16 *)samples, count, true);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+
+    if (count < frames) {
+        atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ring->dropped_frames, frames - count, memory_order_relaxed);
+    }
+
+    return count;
+}
+
+void audio_ring_read(audio_ring *ring, s16 *samples, u32 frames) {
+    u32 tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    u32 head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    u32 count = head - tail < frames ? head - tail : frames;
+
+    copy(ring, tail, samples, count, false);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+
+    if (count < frames) {
+        memset(samples + count * 2, 0, (frames - count) * 2 * sizeof(s16));
+        atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ring->silent_frames, frames - count, memory_order_relaxed);
+    }
+}
+
+u32 audio_ring_fill(audio_ring *ring) {
+    return atomic_load(&ring->head) - atomic_load(&ring->tail);
+}
+
+void audio_ring_get_stats(audio_ring *ring, audio_ring_stats *stats) {
+    stats->underruns = atomic_load_explicit(&ring->underruns, memory_order_relaxed);
+    stats->overruns = atomic_load_explicit(&ring->overruns, memory_order_relaxed);
+    stats->silent_frames = atomic_load_explicit(&ring->silent_frames, memory_order_relaxed);
+    stats->dropped_frames = atomic_load_explicit(&ring->dropped_frames, memory_order_relaxed);
+}
@@ -0,0 +1,305 @@
+#include <battery.h>
+#include <cart.h>
+#include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+//the flusher waits this long after the first dirty block for more writes.
+#define COALESCE_MS 250
+
+#define BLOCK_SIZE (1 << CART_DIRTY_SHIFT)
+
+static battery_context main_ctx;
+static _Thread_local battery_context *ctx = &main_ctx;
+
+battery_context *battery_get_context() {
+    return ctx;
+}
+
+void battery_set_context(battery_context *context) {
+    ctx = context;
+}
+
+static bool any_dirty(const u32 *bits) {
+    for (int i=0; i<CART_DIRTY_WORDS; i++) {
+        if (bits[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool has_work() {
+    return ctx->trailer_pending || any_dirty(ctx->pending);
+}
+
+//the clock keeps running, it is only saved when the game set it and at the end.
+static void take_trailer() {
+    mbc_rtc_save(ctx->trailer);
+    ctx->trailer_pending = true;
+    ctx->cart->rtc_dirty = false;
+}
+
+//moves the cart's dirty blocks into the shadow buffer, call with the lock held.
+static void take_dirty() {
+    if (ctx->cart->rtc_dirty) {
+        take_trailer();
+    }
+
+    for (int i=0; i<CART_DIRTY_WORDS; i++) {
+        u32 bits = ctx->cart->ram_dirty[i];
+
+        while (bits) {
+            u32 block = i * 32 + __builtin_ctz(bits);
+            u32 offset = block << CART_DIRTY_SHIFT;
+
+            page_read(ctx->cart->ram_pages, offset, ctx->shadow + offset, BLOCK_SIZE);
+            bits &= bits - 1;
+        }
+
+        ctx->pending[i] |= ctx->cart->ram_dirty[i];
+        ctx->cart->ram_dirty[i] = 0;
+    }
+}
+
+static void write_blocks(const u32 *bits, battery_stats *stats) {
+    u32 blocks = CART_DIRTY_WORDS * 32;
+
+    for (u32 block=0; block<blocks; ) {
+        if (!(bits[block >> 5] & (1u << (block & 31)))) {
+            block++;
+            continue;
+        }
+
+        u32 first = block;
+
+        while (block < blocks && (bits[block >> 5] & (1u << (block & 31)))) {
+            block++;
+        }
+
+        u32 offset = first << CART_DIRTY_SHIFT;
+        u32 size = (block - first) << CART_DIRTY_SHIFT;
+
+        if (pwrite(ctx->fd, ctx->out + offset, size, offset) != (ssize_t)size) {
+            stats->errors++;
+        }
+
+        stats->writes++;
+        stats->bytes += size;
+    }
+}
+
+static void add_stats(const battery_stats *stats) {
+    ctx->stats.flushes += stats->flushes;
+    ctx->stats.writes += stats->writes;
+    ctx->stats.bytes += stats->bytes;
+    ctx->stats.syncs += stats->syncs;
+    ctx->stats.errors += stats->errors;
+}
+
+static void *flush_run(void *p) {
+    //the flusher works for the machine that started it.
+    ctx = p;
+
+    pthread_mutex_lock(&ctx->lock);
+
+    while (true) {
+        while (!ctx->stop && !has_work()) {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+        }
+
+        //coalesce, a game usually writes its save over several frames.
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += COALESCE_MS * 1000000L;
+        until.tv_sec += until.tv_nsec / 1000000000L;
+        until.tv_nsec %= 1000000000L;
+
+        while (!ctx->stop && pthread_cond_timedwait(&ctx->cond, &ctx->lock, &until) == 0) {
+        }
+
+        u32 bits[CART_DIRTY_WORDS];
+        memcpy(bits, ctx->pending, sizeof(bits));
+        memset(ctx->pending, 0, sizeof(ctx->pending));
+
+        bool trailer = ctx->trailer_pending;
+        memcpy(ctx->out_trailer, ctx->trailer, sizeof(ctx->trailer));
+        ctx->trailer_pending = false;
+
+        for (int i=0; i<CART_DIRTY_WORDS; i++) {
+            for (u32 b = bits[i]; b; b &= b - 1) {
+                u32 offset = (i * 32 + __builtin_ctz(b)) << CART_DIRTY_SHIFT;
+                memcpy(ctx->out + offset, ctx->shadow + offset, BLOCK_SIZE);
+            }
+        }
+
+        bool stop = ctx->stop;
+        pthread_mutex_unlock(&ctx->lock);
+
+        battery_stats stats = {0};
+
+        if (trailer) {
+            if (pwrite(ctx->fd, ctx->out_trailer, RTC_TRAILER_SIZE, ctx->ram_size) != RTC_TRAILER_SIZE) {
+                stats.errors++;
+            }
+
+            stats.writes++;
+            stats.bytes += RTC_TRAILER_SIZE;
+        }
+
+        if (trailer || any_dirty(bits)) {
+            write_blocks(bits, &stats);
+            stats.flushes++;
+
+            if (ctx->sync == BATTERY_SYNC_ALWAYS) {
+                fsync(ctx->fd);
+                stats.syncs++;
+            }
+        }
+
+        pthread_mutex_lock(&ctx->lock);
+        add_stats(&stats);
+
+        if (stop && !has_work()) {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->lock);
+    return 0;
+}
+
+bool battery_start(battery_sync sync) {
+    battery_stop();
+
+    cart_context *cart = cart_get_context();
+
+    if (!cart->battery || !cart_battery_size()) {
+        return false;
+    }
+
+    char fn[1048];
+    sprintf(fn, "%s.battery", cart->filename);
+
+    int fd = open(fn, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", fn);
+        return false;
+    }
+
+    //room for every bank, a new file starts as zeroed ram.
+    if (lseek(fd, 0, SEEK_END) < (off_t)cart_battery_size() && ftruncate(fd, cart_battery_size())) {
+        fprintf(stderr, "FAILED TO RESIZE: %s\n", fn);
+        close(fd);
+        return false;
+    }
+
+    ctx->shadow = malloc(CART_RAM_SIZE);
+    ctx->out = malloc(CART_RAM_SIZE);
+
+    if (!ctx->shadow || !ctx->out) {
+        fprintf(stderr, "FAILED TO ALLOCATE BATTERY BUFFERS!\n");
+        free(ctx->shadow);
+        free(ctx->out);
+        close(fd);
+        return false;
+    }
+
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    memset(ctx->pending, 0, sizeof(ctx->pending));
+    ctx->sync = sync;
+    ctx->fd = fd;
+    ctx->cart = cart;
+    ctx->ram_size = cart_ram_size();
+    ctx->stop = false;
+    ctx->trailer_pending = false;
+
+    if (cart->has_rtc) {
+        take_trailer();
+    }
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->cond, NULL);
+
+    if (pthread_create(&ctx->thread, NULL, flush_run, ctx)) {
+        fprintf(stderr, "FAILED TO START BATTERY THREAD!\n");
+        pthread_mutex_destroy(&ctx->lock);
+        pthread_cond_destroy(&ctx->cond);
+        free(ctx->shadow);
+        free(ctx->out);
+        close(fd);
+        return false;
+    }
+
+    ctx->active = true;
+    return true;
+}
+
+void battery_stop() {
+    if (!ctx->active) {
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    take_dirty();
+
+    if (ctx->cart->has_rtc) {
+        take_trailer();
+    }
+
+    ctx->stop = true;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+
+    pthread_join(ctx->thread, NULL);
+
+    if (ctx->sync != BATTERY_SYNC_NEVER) {
+        fsync(ctx->fd);
+        ctx->stats.syncs++;
+    }
+
+    close(ctx->fd);
+    pthread_mutex_destroy(&ctx->lock);
+    pthread_cond_destroy(&ctx->cond);
+    free(ctx->shadow);
+    free(ctx->out);
+    ctx->shadow = NULL;
+    ctx->out = NULL;
+
+    ctx->cart->need_save = false;
+    ctx->active = false;
+}
+
+bool battery_active() {
+    return ctx->active;
+}
+
+void battery_frame() {
+    if (!ctx->active || (!any_dirty(ctx->cart->ram_dirty) && !ctx->cart->rtc_dirty)) {
+        return;
+    }
+
+    //the flusher is copying, the blocks stay dirty until the next frame.
+    if (pthread_mutex_trylock(&ctx->lock)) {
+        return;
+    }
+
+    take_dirty();
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+void battery_get_stats(battery_stats *stats) {
+    if (!ctx->active) {
+        *stats = ctx->stats;
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->stats;
+    pthread_mutex_unlock(&ctx->lock);
+}
@@ -0,0 +1,185 @@
+#include <blip.h>
+#include <string.h>
+#include <math.h>
+
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//positions between two output samples a step can start at, a step is
+//moved to the nearest one.
+#define PHASE_BITS 8
+#define PHASES (1 << PHASE_BITS)
+
+//a kernel sums to 1 << UNITY_BITS.
+#define UNITY_BITS 14
+
+//the steps keep frequencies up to this fraction of the output's nyquist.
+#define CUTOFF 0.95
+
+//of the windowed sinc, in output samples.
+#define HALF_WIDTH 7
+
+//the offset follows the output with a time constant of 1 << DC_SHIFT samples.
+#define DC_SHIFT 9
+
+//the difference of the band-limited step over each output sample, for
+//steps starting phase / PHASES of a sample late.
+static s16 kernel[PHASES][BLIP_TAPS];
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+static double impulse(double x) {
+    if (fabs(x) >= HALF_WIDTH) {
+        return 0;
+    }
+
+    double sinc = x == 0 ? CUTOFF : sin(M_PI * CUTOFF * x) / (M_PI * x);
+    double window = 0.42 + 0.5 * cos(M_PI * x / HALF_WIDTH) + 0.08 * cos(2 * M_PI * x / HALF_WIDTH);
+
+    return sinc * window;
+}
+
+static void make_kernel() {
+    //the step is the integral of the impulse, on a grid of 1/PHASES/8 samples.
+    enum { RES = PHASES * 8, POINTS = HALF_WIDTH * 2 * RES + 1 };
+    static double step[POINTS];
+    double sum = 0;
+
+    step[0] = 0;
+
+    for (int j=1; j<POINTS; j++) {
+        double x = -HALF_WIDTH + (j - 0.5) / RES;
+        sum += impulse(x) / RES;
+        step[j] = sum;
+    }
+
+    for (int p=0; p<PHASES; p++) {
+        int total = 0;
+        int largest = 0;
+
+        for (int i=0; i<BLIP_TAPS; i++) {
+            //step(x) at x = i - 7 - p/PHASES minus the same a sample earlier.
+            double v[2];
+
+            for (int k=0; k<2; k++) {
+                int j = (i - k - HALF_WIDTH) * RES - p * (RES / PHASES) + HALF_WIDTH * RES;
+                v[k] = j <= 0 ? 0 : (j >= POINTS ? sum : step[j]);
+            }
+
+            kernel[p][i] = (s16)lround((v[0] - v[1]) / sum * (1 << UNITY_BITS));
+            total += kernel[p][i];
+
+            if (abs(kernel[p][i]) > abs(kernel[p][largest])) {
+                largest = i;
+            }
+        }
+
+        //rounding must not leave an offset behind every step.
+        kernel[p][largest] += (1 << UNITY_BITS) - total;
+    }
+}
+
+bool blip_init(blip_buffer *b, u32 samples) {
+    pthread_once(&kernel_once, make_kernel);
+
+    memset(b, 0, sizeof(*b));
+    b->size = samples;
+    b->deltas = calloc(samples + BLIP_TAPS, sizeof(s32));
+
+    return b->deltas != NULL;
+}
+
+void blip_free(blip_buffer *b) {
+    free(b->deltas);
+    b->deltas = NULL;
+}
+
+void blip_set_rates(blip_buffer *b, double clock_rate, double sample_rate) {
+    b->factor = (u64)(sample_rate / clock_rate * 4294967296.0 + 0.5);
+}
+
+void blip_clear(blip_buffer *b) {
+    memset(b->deltas, 0, (b->size + BLIP_TAPS) * sizeof(s32));
+    b->offset = 0;
+    b->avail = 0;
+    b->integrator = 0;
+    b->dc = 0;
+}
+
+void blip_add_delta(blip_buffer *b, u32 time, int delta) {
+    u64 pos = b->offset + time * b->factor;
+    u32 index = pos >> 32;
+
+    //nobody read in time, the change is lost.
+    if (index > b->size) {
+        return;
+    }
+
+    const s16 *k = kernel[(u32)pos >> (32 - PHASE_BITS)];
+    s32 *out = b->deltas + index;
+
+    for (int i=0; i<BLIP_TAPS; i++) {
+        out[i] += k[i] * delta;
+    }
+}
+
+u32 blip_end_frame(blip_buffer *b, u32 time) {
+    b->offset += time * b->factor;
+    b->avail = b->offset >> 32;
+
+    if (b->avail > b->size) {
+        b->avail = b->size;
+    }
+
+    return b->avail;
+}
+
+//the next sample, twice the kernel's scale so a full scale wave fills s16.
+static inline s32 next_sample(blip_buffer *b, u32 i) {
+    b->integrator += b->deltas[i];
+
+    s32 s = b->integrator >> (UNITY_BITS - 1);
+    b->dc += ((s << 8) - b->dc) >> DC_SHIFT;
+    s -= b->dc >> 8;
+
+    return s < -32768 ? -32768 : (s > 32767 ? 32767 : s);
+}
+
+//the deltas past the end of the frame reach no further than BLIP_TAPS.
+static void remove_samples(blip_buffer *b, u32 count) {
+    u32 remaining = b->avail + BLIP_TAPS - count;
+
+    memmove(b->deltas, b->deltas + count, remaining * sizeof(s32));
+    memset(b->deltas + remaining, 0, count * sizeof(s32));
+
+    b->offset -= (u64)count << 32;
+    b->avail -= count;
+}
+
+u32 blip_read_s16(blip_buffer *b, s16 *out, u32 count, int stride) {
+    if (count > b->avail) {
+        count = b->avail;
+    }
+
+    for (u32 i=0; i<count; i++) {
+        out[i * stride] = next_sample(b, i);
+    }
+
+    remove_samples(b, count);
+    return count;
+}
+
+u32 blip_read_float(blip_buffer *b, float *out, u32 count, int stride) {
+    if (count > b->avail) {
+        count = b->avail;
+    }
+
+    for (u32 i=0; i<count; i++) {
+        out[i * stride] = next_sample(b, i) / 32768.0f;
+    }
+
+    remove_samples(b, count);
+    return count;
+}
@@ -1,55 +1,58 @@
 #include <cart.h>
+#include <emu.h>
 #include <string.h>
 
-static cart_context ctx;
+static cart_context main_ctx;
+static _Thread_local cart_context *ctx = &main_ctx;
+
+//no cartridge info on stdout, for batch runs.
+static bool quiet = false;
 
 cart_context *cart_get_context() {
-    return &ctx;
+    return ctx;
 }
 
-bool cart_need_save() {
-    return ctx.need_save;
+void cart_set_context(cart_context *context) {
+    ctx = context;
 }
 
-bool cart_mbc1() {
-    return BETWEEN(ctx.header->cartiage_type, 1, 3);
+bool cart_need_save() {
+    return ctx->need_save;
 }
 
-bool cart_battery() {
-    //mbc1 only for now...
-    return ctx.header->cartiage_type == 3;
+bool cart_cgb() {
+    return ctx->cgb;
 }
 
-static const char *ROM_TYPES[] = {
-    "ROM ONLY",
-    "MBC1",
-    "MBC1+RAM",
-    "MBC1+RAM+BATTERY",
-    "MBC2",
-    "MBC2+BATTERY",
-    "ROM+RAM",
-    "ROM+RAM+BATTERY",
-    "MMM01",
-    "MMM01+RAM",
-    "MMM01+RAM+BATTERY",
-    "MBC3+TIMER+BATTERY",
-    "MBC3+TIMER+RAM+BATTERY",
-    "MBC3",
-    "MBC3+RAM",
-    "MBC3+RAM+BATTERY",
-    "MBC4",
-    "MBC4+RAM",
-    "MBC4+RAM+BATTERY",
-    "MBC5",
-    "MBC5+RAM",
-    "MBC5+RAM+BATTERY",
-    "MBC5+RUMBLE",
-    "MBC5+RUMBLE+RAM",
-    "MBC5+RUMBLE+RAM+BATTERY",
-    "POCKET CAMERA",
-    "BANDAI TAMA5",
-    "HuC3",
-    "HuC1+RAM+BATTERY"
+static const char *ROM_TYPES[0x100] = {
+    [0x00] = "ROM ONLY",
+    [0x01] = "MBC1",
+    [0x02] = "MBC1+RAM",
+    [0x03] = "MBC1+RAM+BATTERY",
+    [0x05] = "MBC2",
+    [0x06] = "MBC2+BATTERY",
+    [0x08] = "ROM+RAM",
+    [0x09] = "ROM+RAM+BATTERY",
+    [0x0B] = "MMM01",
+    [0x0C] = "MMM01+RAM",
+    [0x0D] = "MMM01+RAM+BATTERY",
+    [0x0F] = "MBC3+TIMER+BATTERY",
+    [0x10] = "MBC3+TIMER+RAM+BATTERY",
+    [0x11] = "MBC3",
+    [0x12] = "MBC3+RAM",
+    [0x13] = "MBC3+RAM+BATTERY",
+    [0x19] = "MBC5",
+    [0x1A] = "MBC5+RAM",
+    [0x1B] = "MBC5+RAM+BATTERY",
+    [0x1C] = "MBC5+RUMBLE",
+    [0x1D] = "MBC5+RUMBLE+RAM",
+    [0x1E] = "MBC5+RUMBLE+RAM+BATTERY",
+    [0x20] = "MBC6",
+    [0x22] = "MBC7+SENSOR+RUMBLE+RAM+BATTERY",
+    [0xFC] = "POCKET CAMERA",
+    [0xFD] = "BANDAI TAMA5",
+    [0xFE] = "HuC3",
+    [0xFF] = "HuC1+RAM+BATTERY"
 };
 
 static const char *LIC_CODE[0xA5] = {
@@ -117,143 +120,194 @@ static const char *LIC_CODE[0xA5] = {
 };
 
 const char *cart_lic_name() {
-    if (ctx.header->new_license_code <= 0xA4) {
-        return LIC_CODE[ctx.header->old_license_code];
+    if (ctx->header->new_license_code <= 0xA4) {
+        return LIC_CODE[ctx->header->old_license_code];
     }
 
     return "UNKNOWN";
 }
 
 const char *cart_type_name() {
-    if (ctx.header->cartiage_type <= 0x22) {
-        return ROM_TYPES[ctx.header->cartiage_type];
+    if (ROM_TYPES[ctx->header->cartiage_type]) {
+        return ROM_TYPES[ctx->header->cartiage_type];
     }
 
     return "UNKNOWN";
 }
 
+void cart_set_quiet(bool value) {
+    quiet = value;
+}
+
+static void cart_print_info() {
+    printf("Cartridge loaded:\n");
+    printf("\t Title        : %s\n", ctx->title);
+    printf("\t Type         : %2.2X (%s)\n", ctx->header->cartiage_type, cart_type_name());
+    printf("\t Rom Size     : %2.2X %d KB\n", ctx->header->rom_size, 32 << ctx->header->rom_size);
+    printf("\t Ram Size     : %2.2X\n", ctx->header->ram_size);
+    printf("\t Lic Code     : %2.2X (%s)\n", ctx->header->new_license_code, cart_lic_name());
+    printf("\t Rom Version  : %2.2X\n", ctx->header->mask_rom_version_number);
+
+    // Check sum
+    u16 x = 0;
+    for (u16 i=0x0134; i<=0x014C; i++) {
+        x = x - ctx->rom_data[i] - 1;
+    }
+    printf("\t CheckSum: %s\n", (x & 0xFF)? "PASSED":"FAILED");
+}
+
 void cart_setup_banking() {
-    for (int i=0; i<16; i++) {
-        ctx.ram_banks[i] = 0;
-
-        if ((ctx.header->ram_size == 2 && i == 0) ||
-            (ctx.header->ram_size == 3 && i < 4) || 
-            (ctx.header->ram_size == 4 && i < 16) || 
-            (ctx.header->ram_size == 5 && i < 8)) {
-            ctx.ram_banks[i] = malloc(0x2000);
-            memset(ctx.ram_banks[i], 0, 0x2000);
-        }
+    switch (ctx->header->ram_size) {
+        case 2: ctx->ram_bank_count = 1; break;
+        case 3: ctx->ram_bank_count = 4; break;
+        case 4: ctx->ram_bank_count = 16; break;
+        case 5: ctx->ram_bank_count = 8; break;
+        default: ctx->ram_bank_count = 0; break;
+    }
+
+    //pages are allocated on the first write, ram starts zeroed.
+    page_release(ctx->ram_pages, CART_RAM_BANKS * CART_RAM_BANK_PAGES);
+    memset(ctx->ram_dirty, 0, sizeof(ctx->ram_dirty));
+
+    ctx->ram_enabled = false;
+    ctx->ram_banking = false;
+    ctx->banking_mode = 0;
+    ctx->rom_bank_value = 0;
+    ctx->ram_bank_value = 0;
+
+    memset(&ctx->rtc, 0, sizeof(ctx->rtc));
+    ctx->rtc.ticks = emu_get_context()->ticks;
+    ctx->rtc_dirty = false;
+
+    ctx->ram_bank = cart_ram_bank(0);
+    ctx->rom_banks = ctx->rom_size / 0x4000;
+
+    ctx->mapper->map();
+    cart_map_ram();
+}
+
+mem_page **cart_ram_bank(int bank) {
+    if (bank >= ctx->ram_bank_count) {
+        return NULL;
+    }
+
+    return ctx->ram_pages + bank * CART_RAM_BANK_PAGES;
+}
+
+u32 cart_ram_size() {
+    return ctx->ram_bank_count * CART_RAM_BANK_SIZE;
+}
+
+u32 cart_battery_size() {
+    return cart_ram_size() + (ctx->has_rtc ? RTC_TRAILER_SIZE : 0);
+}
+
+void cart_mark_dirty(u32 offset, u32 size) {
+    for (u32 block = offset >> CART_DIRTY_SHIFT; block <= (offset + size - 1) >> CART_DIRTY_SHIFT; block++) {
+        ctx->ram_dirty[block >> 5] |= 1u << (block & 31);
     }
+}
 
-    ctx.ram_bank = ctx.ram_banks[0];
-    ctx.rom_bank_x = ctx.rom_data + 0x4000; //rom bank 1
+static u32 ext_ram_size() {
+    return ctx->ext_ram_size < cart_ram_size() ? ctx->ext_ram_size : cart_ram_size();
 }
 
 void cart_save_ext_ram() {
-    if (!ctx.ram_bank) {
+    if (!ctx->ram_bank_count) {
         return;
     }
 
-    memcpy(ctx.ext_ram, ctx.ram_bank, ctx.ext_ram_size);
-}
+    if (!ctx->ext_ram) {
+        ctx->ext_ram = malloc(CART_RAM_SIZE);
+    }
 
+    page_read(ctx->ram_pages, 0, ctx->ext_ram, ext_ram_size());
+}
 
 void cart_load_ext_ram() {
-    if (!ctx.ram_bank) {
+    if (!ctx->ram_bank_count || !ctx->ext_ram) {
         return;
     }
 
-    memcpy(ctx.ram_bank, ctx.ext_ram, ctx.ext_ram_size);
+    page_write(ctx->ram_pages, 0, ctx->ext_ram, ext_ram_size());
 }
 
-bool cart_init(void* rom_data, size_t rom_size) {
-    ctx.rom_size = rom_size;
-    ctx.rom_data = rom_data;
+static void cart_attach(rom_image *rom) {
+    cart_unload();
 
-    ctx.header = (rom_header *)(ctx.rom_data + 0x100);
-    ctx.header->title[15] = 0;
-    ctx.battery = cart_battery();
-    ctx.need_save = false;
-    ctx.ext_ram_size = 0;
+    ctx->rom = rom;
+    ctx->rom_size = rom->size;
+    ctx->rom_data = rom->data;
 
-    printf("Cartridge loaded:\n");
-    printf("\t Title        : %s\n", ctx.header->title);
-    printf("\t Type         : %2.2X (%s)\n", ctx.header->cartiage_type, cart_type_name());
-    printf("\t Rom Size     : %2.2X %d KB\n", ctx.header->rom_size, 32 << ctx.header->rom_size);
-    printf("\t Ram Size     : %2.2X\n", ctx.header->ram_size);
-    printf("\t Lic Code     : %2.2X (%s)\n", ctx.header->new_license_code, cart_lic_name());
-    printf("\t Rom Version  : %2.2X\n", ctx.header->mask_rom_version_number);
+    ctx->header = (const rom_header *)(ctx->rom_data + 0x100);
+    memcpy(ctx->title, ctx->header->title, sizeof(ctx->title) - 1);
+    ctx->title[sizeof(ctx->title) - 1] = 0;
+    ctx->cgb = (u8)ctx->header->title[15] & 0x80;
+
+    const cart_type_info *type = mbc_type_info(ctx->header->cartiage_type);
+    ctx->mapper = type->mapper;
+    ctx->battery = type->battery;
+    ctx->has_rtc = type->rtc;
+    ctx->need_save = false;
+    ctx->ext_ram_size = 0;
 
 	cart_setup_banking();
+}
 
-    // Check sum
-    u16 x = 0;
-    for (u16 i=0x0134; i<=0x014C; i++) {
-        x = x - ctx.rom_data[i] - 1;
-    }
-    printf("\t CheckSum: %s\n", (x & 0xFF)? "PASSED":"FAILED");
+void cart_unload() {
+    rom_release(ctx->rom);
 
-    return true;
+    ctx->rom = NULL;
+    ctx->rom_data = NULL;
+    ctx->header = NULL;
 }
 
-bool cart_load(char *cart) {
-    snprintf(ctx.filename, sizeof(ctx.filename), "%s", cart);
-
-    FILE *fp = fopen(cart, "r");
+bool cart_init(void* rom_data, size_t rom_size) {
+    rom_image *rom = rom_from_memory(rom_data, rom_size);
 
-    if (!fp) {
-        printf("Failed to open file: %s\n", ctx.filename);
+    if (!rom) {
+        printf("Not a rom file\n");
         return false;
     }
 
-    printf("Opened file: %s\n", ctx.filename);
-
-    fseek(fp, 0, SEEK_END);
-    ctx.rom_size = ftell(fp);
+    cart_attach(rom);
 
-    rewind(fp);
+    if (!quiet) {
+        cart_print_info();
+    }
 
-    ctx.rom_data = malloc(ctx.rom_size);
-    fread(ctx.rom_data, ctx.rom_size, 1, fp);
-    fclose(fp);
+    return true;
+}
 
-    ctx.header = (rom_header *)(ctx.rom_data + 0x100);
+bool cart_load(char *cart) {
+    rom_image *rom = rom_open(cart);
 
-    // TODO(nkaptx)
-    ctx.header->title[15] = 0;
-    ctx.battery = cart_battery();
-    ctx.need_save = false;
+    if (!rom) {
+        printf("Failed to open file: %s\n", cart);
+        return false;
+    }
 
-    printf("Cartridge loaded:\n");
-    printf("\t Title        : %s\n", ctx.header->title);
-    printf("\t Type         : %2.2X (%s)\n", ctx.header->cartiage_type, cart_type_name());
-    printf("\t Rom Size     : %2.2X %d KB\n", ctx.header->rom_size, 32 << ctx.header->rom_size);
-    printf("\t Ram Size     : %2.2X\n", ctx.header->ram_size);
-    printf("\t Lic Code     : %2.2X (%s)\n", ctx.header->new_license_code, cart_lic_name());
-    printf("\t Rom Version  : %2.2X\n", ctx.header->mask_rom_version_number);
+    cart_attach(rom);
+    snprintf(ctx->filename, sizeof(ctx->filename), "%s", cart);
 
-	cart_setup_banking();
-
-    // Check sum
-    u16 x = 0;
-    for (u16 i=0x0134; i<=0x014C; i++) {
-        x = x - ctx.rom_data[i] - 1;
+    if (!quiet) {
+        printf("Opened file: %s\n", ctx->filename);
+        cart_print_info();
     }
-    printf("\t CheckSum: %s\n", (x & 0xFF)? "PASSED":"FAILED");
 
-    if (ctx.battery) {
+    if (ctx->battery) {
         cart_battery_load();
     }
     return true;
 }
 
 void cart_battery_load() {
-    if (!ctx.ram_bank) {
+    if (!cart_battery_size()) {
         return;
     }
 
     char fn[1048];
-    sprintf(fn, "%s.battery", ctx.filename);
+    sprintf(fn, "%s.battery", ctx->filename);
     FILE *fp = fopen(fn, "rb");
 
     if (!fp) {
@@ -261,17 +315,28 @@ void cart_battery_load() {
         return;
     }
 
-    fread(ctx.ram_bank, 0x2000, 1, fp);
+    //older saves only hold the first bank.
+    u8 data[CART_RAM_BANK_SIZE];
+
+    for (int i=0; i<ctx->ram_bank_count && fread(data, sizeof(data), 1, fp) == 1; i++) {
+        page_write(cart_ram_bank(i), 0, data, sizeof(data));
+    }
+
+    if (ctx->has_rtc && !fseek(fp, cart_ram_size(), SEEK_SET)) {
+        u8 trailer[RTC_TRAILER_SIZE];
+        mbc_rtc_load(trailer, fread(trailer, 1, sizeof(trailer), fp));
+    }
+
     fclose(fp);
 }
 
 void cart_battery_save() {
-    if (!ctx.ram_bank) {
+    if (!cart_battery_size()) {
         return;
     }
 
     char fn[1048];
-    sprintf(fn, "%s.battery", ctx.filename);
+    sprintf(fn, "%s.battery", ctx->filename);
     FILE *fp = fopen(fn, "wb");
 
     if (!fp) {
@@ -279,92 +344,60 @@ void cart_battery_save() {
         return;
     }
 
-    fwrite(ctx.ram_bank, 0x2000, 1, fp);
-    fclose(fp);
-}
+    u8 data[CART_RAM_BANK_SIZE];
 
-u8 cart_read(u16 address) {
-    if (!cart_mbc1() || address < 0x4000) {
-        return ctx.rom_data[address];
+    for (int i=0; i<ctx->ram_bank_count; i++) {
+        page_read(cart_ram_bank(i), 0, data, sizeof(data));
+        fwrite(data, sizeof(data), 1, fp);
     }
 
-    if ((address & 0xE000) == 0xA000) {
-        if (!ctx.ram_enabled) {
-            return 0xFF;
-        }
-
-        if (!ctx.ram_bank) {
-            return 0xFF;
-        }
-
-        return ctx.ram_bank[address - 0xA000];
+    if (ctx->has_rtc) {
+        u8 trailer[RTC_TRAILER_SIZE];
+        mbc_rtc_save(trailer);
+        fwrite(trailer, sizeof(trailer), 1, fp);
     }
 
-    return ctx.rom_bank_x[address - 0x4000];
+    fclose(fp);
+    ctx->need_save = false;
 }
 
-void cart_write(u16 address, u8 value) {
-    if (!cart_mbc1()) {
-        return;
-    }
+void cart_map_ram() {
+    ctx->ram_map = ctx->ram_enabled || ctx->mapper->ram_always ? ctx->ram_bank : NULL;
+}
 
-    if (address < 0x2000) {
-        ctx.ram_enabled = ((value & 0xF) == 0xA);
+u8 cart_read(u16 address) {
+    if (address < 0x4000) {
+        return ctx->rom_bank_0[address];
     }
 
-    if ((address & 0xE000) == 0x2000) {
-        //rom bank number
-        if (value == 0) {
-            value = 1;
-        }
-
-        value &= 0b11111;
-
-        ctx.rom_bank_value = value;
-        ctx.rom_bank_x = ctx.rom_data + (0x4000 * ctx.rom_bank_value);
+    if (address < 0x8000) {
+        return ctx->rom_bank_x[address - 0x4000];
     }
 
-    if ((address & 0xE000) == 0x4000) {
-        //ram bank number
-        ctx.ram_bank_value = value & 0b11;
-
-        if (ctx.ram_banking) {
-            if (cart_need_save()) {
-                cart_save_ext_ram();
-            }
-
-            ctx.ram_bank = ctx.ram_banks[ctx.ram_bank_value];
-        }
+    if (ctx->ram_map) {
+        return page_read_u8(ctx->ram_map, address - 0xA000);
     }
 
-    if ((address & 0xE000) == 0x6000) {
-        //banking mode select
-        ctx.banking_mode = value & 1;
-
-        ctx.ram_banking = ctx.banking_mode;
-
-        if (ctx.ram_banking) {
-            if (cart_need_save()) {
-                cart_save_ext_ram();
-            }
+    return ctx->mapper->ram_read(address);
+}
 
-            ctx.ram_bank = ctx.ram_banks[ctx.ram_bank_value];
-        }
+void cart_write(u16 address, u8 value) {
+    if (address < 0x8000) {
+        ctx->mapper->write(address, value);
+        cart_map_ram();
+        return;
     }
 
-    if ((address & 0xE000) == 0xA000) {
-        if (!ctx.ram_enabled) {
-            return;
-        }
-
-        if (!ctx.ram_bank) {
-            return;
-        }
+    if (!ctx->ram_map) {
+        ctx->mapper->ram_write(address, value);
+        return;
+    }
 
-        ctx.ram_bank[address - 0xA000] = value;
+    page_write_u8(ctx->ram_map, address - 0xA000, value);
 
-        if (ctx.battery) {
-            ctx.need_save = true;
-        }
+    if (ctx->battery) {
+        u32 offset = (ctx->ram_map - ctx->ram_pages) * PAGE_SIZE + address - 0xA000;
+        ctx->ram_dirty[offset >> (CART_DIRTY_SHIFT + 5)] |= 1u << ((offset >> CART_DIRTY_SHIFT) & 31);
+        ctx->need_save = true;
     }
 }
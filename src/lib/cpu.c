@@ -1,52 +1,77 @@
 #include <cpu.h>
 #include <bus.h>
 #include <emu.h>
-#include <dbg.h>
 #include <timer.h>
 #include <interrupts.h>
+#include <cart.h>
+#include <ram.h>
+#include <dma.h>
 
 #define CPU_DEBUG 0
 
-cpu_context ctx = {0};
+static cpu_context main_ctx;
+
+//every thread runs its own machine, see machine.h. The main thread and
+//the frontend's cpu thread share the default one.
+_Thread_local cpu_context *ctx = &main_ctx;
 
 cpu_context *cpu_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void cpu_set_context(cpu_context *context) {
+    ctx = context;
 }
 
 void cpu_init() {
-    ctx.regs.pc = 0x100;
-    ctx.regs.sp = 0xFFFE;
-    *((short *)&ctx.regs.a) = 0xB001;
-    *((short *)&ctx.regs.b) = 0x1300;
-    *((short *)&ctx.regs.d) = 0xD800;
-    *((short *)&ctx.regs.h) = 0x4D01;
-    ctx.ie_register = 0;
-    ctx.int_flags = 0;
-    ctx.int_master_enabled = false;
-    ctx.enabling_ime = false;
+    ctx->regs.pc = 0x100;
+    ctx->regs.sp = 0xFFFE;
+    *((short *)&ctx->regs.a) = 0xB001;
+    *((short *)&ctx->regs.b) = 0x1300;
+    *((short *)&ctx->regs.d) = 0xD800;
+    *((short *)&ctx->regs.h) = 0x4D01;
+    ctx->ie_register = 0;
+    ctx->int_flags = 0;
+    ctx->int_master_enabled = false;
+    ctx->enabling_ime = false;
+    ctx->speed_armed = false;
+    ctx->double_speed = false;
+    ram_svbk_write(0);
+
+    if (cart_cgb()) {
+        //A = 11 tells the game it runs on a cgb.
+        *((short *)&ctx->regs.a) = 0x8011;
+        *((short *)&ctx->regs.b) = 0x0000;
+        *((short *)&ctx->regs.d) = 0x56FF;
+        *((short *)&ctx->regs.h) = 0x0D00;
+    }
 
     timer_get_context()->div = 0xABCC;
 }
 
 static void fetch_instruction() {
-    ctx.cur_opcode = bus_read(ctx.regs.pc++);
-    ctx.cur_inst = instruction_by_opcode(ctx.cur_opcode);
+    ctx->cur_opcode = bus_read(ctx->regs.pc++);
+    ctx->cur_inst = instruction_by_opcode(ctx->cur_opcode);
 }
 
 static void execute() {
-    IN_PROC proc = inst_get_processor(ctx.cur_inst->type);
+    IN_PROC proc = inst_get_processor(ctx->cur_inst->type);
     if (!proc) {
-        printf("Not implement for %02X\n", ctx.cur_inst->type);
+        printf("Not implement for %02X\n", ctx->cur_inst->type);
         NO_IMPL
     }
 
-    proc(&ctx);
+    proc(ctx);
 }
 
 bool cpu_step() {
+    if (dma_get_context()->stall) {
+        //a vram dma transfer has the bus.
+        emu_cycles(dma_take_stall());
+    }
 
-    if (!ctx.halted) {
-        u16 pc = ctx.regs.pc;
+    if (!ctx->halted) {
+        u16 pc = ctx->regs.pc;
 
         fetch_instruction();
         emu_cycles(1);
@@ -55,61 +80,66 @@ bool cpu_step() {
 #if CPU_DEBUG == 1
         char flags[16];
         sprintf(flags, "%c%c%c%c",
-            ctx.regs.f & (1 << 7) ? 'Z' : '-',
-            ctx.regs.f & (1 << 6) ? 'N' : '-',
-            ctx.regs.f & (1 << 5) ? 'H' : '-',
-            ctx.regs.f & (1 << 4) ? 'C' : '-'
+            ctx->regs.f & (1 << 7) ? 'Z' : '-',
+            ctx->regs.f & (1 << 6) ? 'N' : '-',
+            ctx->regs.f & (1 << 5) ? 'H' : '-',
+            ctx->regs.f & (1 << 4) ? 'C' : '-'
         );
 
         char inst[16];
-        inst_to_str(&ctx, inst);
+        inst_to_str(ctx, inst);
 
         printf("%08lX - %04X: %-12s (%02X %02X %02X) A: %02X F: %s BC: %02X%02X DE: %02X%02X HL: %02X%02X\n", 
             emu_get_context()->ticks,
-            pc, inst, ctx.cur_opcode,
-            bus_read(pc + 1), bus_read(pc + 2), ctx.regs.a, flags, ctx.regs.b, ctx.regs.c,
-            ctx.regs.d, ctx.regs.e, ctx.regs.h, ctx.regs.l);
+            pc, inst, ctx->cur_opcode,
+            bus_read(pc + 1), bus_read(pc + 2), ctx->regs.a, flags, ctx->regs.b, ctx->regs.c,
+            ctx->regs.d, ctx->regs.e, ctx->regs.h, ctx->regs.l);
 #endif
 
-        if (ctx.cur_inst == NULL) {
-            printf("Unknown Instruction! %02X\n", ctx.cur_opcode);
+        if (ctx->cur_inst == NULL) {
+            printf("Unknown Instruction! %02X\n", ctx->cur_opcode);
             exit(-7);
         }
 
-        dbg_update();
-        dbg_print();
-
-        // printf("Executing operation code: %02X  PC: %04X\n", ctx.cur_opcode, pc);
+        // printf("Executing operation code: %02X  PC: %04X\n", ctx->cur_opcode, pc);
         execute();
     } else {
         //is halted...
         emu_cycles(1);
 
-        if (ctx.int_flags) {
-            ctx.halted = false;
+        if (ctx->int_flags) {
+            ctx->halted = false;
         }
     }
 
-    if (ctx.int_master_enabled) {
-        cpu_handle_interrupts(&ctx);
-        ctx.enabling_ime = false;
+    if (ctx->int_master_enabled) {
+        cpu_handle_interrupts(ctx);
+        ctx->enabling_ime = false;
     }
 
-    if (ctx.enabling_ime) {
-        ctx.int_master_enabled = true;
+    if (ctx->enabling_ime) {
+        ctx->int_master_enabled = true;
     }
 
     return true;
 }
 
 u8 cpu_get_ie_register() {
-    return ctx.ie_register;
+    return ctx->ie_register;
 }
 
 void cpu_set_ie_register(u8 value) {
-    ctx.ie_register = value;
+    ctx->ie_register = value;
 }
 
 void cpu_request_interrupt(interrupt_type t) {
-    ctx.int_flags |= t;
+    ctx->int_flags |= t;
+}
+
+u8 cpu_key1_read() {
+    return (ctx->double_speed << 7) | ctx->speed_armed;
+}
+
+void cpu_key1_write(u8 value) {
+    ctx->speed_armed = value & 1;
 }
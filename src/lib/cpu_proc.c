@@ -3,6 +3,7 @@
 #include <bus.h>
 #include <ram.h>
 #include <stack.h>
+#include <timer.h>
 
 void cpu_set_flags(cpu_context *ctx, int8_t z, int8_t n, int8_t h, int8_t c) {
     if (z != -1) {
@@ -193,6 +194,16 @@ static void proc_rla(cpu_context *ctx) {
 }
 
 static void proc_stop(cpu_context *ctx) {
+    if (ctx->speed_armed) {
+        //cgb speed switch, the scheduler clocks the cpu from the next cycle.
+        //div is reset at the old speed, the sequencer goes on at the new one.
+        ctx->speed_armed = false;
+        timer_write(0xFF04, 0);
+        ctx->double_speed = !ctx->double_speed;
+        timer_schedule_sequencer();
+        return;
+    }
+
     fprintf(stderr, "STOPPING!\n");
 }
 
@@ -1,40 +1,163 @@
 #include <dma.h>
 #include <ppu.h>
+#include <lcd.h>
+#include <cpu.h>
+#include <emu.h>
 #include <bus.h>
 
-typedef struct {
-    bool active;
-    u8 byte;
-    u8 value;
-    u8 start_delay;
-} dma_context;
+static dma_context main_ctx;
+static _Thread_local dma_context *ctx = &main_ctx;
 
-static dma_context ctx;
+dma_context *dma_get_context() {
+    return ctx;
+}
+
+void dma_set_context(dma_context *context) {
+    ctx = context;
+}
+
+static void oam_copy(u8 from) {
+    for (int i=from; i<0xA0; i++) {
+        ppu_oam_write(i, bus_read((ctx->value * 0x100) + i));
+    }
+}
 
 void dma_start(u8 start) {
-    ctx.active = true;
-    ctx.byte = 0;
-    ctx.start_delay = 2;
-    ctx.value = start;
+    ctx->active = true;
+    ctx->byte = 0;
+    ctx->start_delay = 2;
+    ctx->value = start;
+    ctx->start = emu_get_context()->cycles;
+
+    //oam reads as FF while active, also for the copy.
+    oam_copy(0);
+}
+
+bool dma_transferring() {
+    if (ctx->active && emu_get_context()->cycles - ctx->start >= DMA_OAM_CYCLES) {
+        ctx->active = false;
+        ctx->byte = 0xA0;
+        ctx->start_delay = 0;
+    }
+
+    return ctx->active;
 }
 
-void dma_tick() {
-    if (!ctx.active) {
+void dma_sync() {
+    if (!dma_transferring()) {
         return;
     }
 
-    if (ctx.start_delay) {
-        ctx.start_delay--;
+    u64 n = emu_get_context()->cycles - ctx->start;
+
+    ctx->start_delay = n < 2 ? 2 - n : 0;
+    ctx->byte = n > 2 ? n - 2 : 0;
+}
+
+void dma_restore() {
+    if (!ctx->active) {
         return;
     }
 
-    ppu_oam_write(ctx.byte, bus_read((ctx.value * 0x100) + ctx.byte));
+    if (ctx->byte >= 0xA0) {
+        ctx->byte = 0xA0;
+        ctx->start_delay = 0;
+    }
+
+    ctx->start = emu_get_context()->cycles - (2 - ctx->start_delay + ctx->byte);
+    oam_copy(ctx->byte);
+}
+
+static void vram_copy_block() {
+    u8 block[16];
+
+    for (int i=0; i<16; i++) {
+        block[i] = bus_read(ctx->vram_src + i);
+    }
+
+    ppu_vram_write_block(0x8000 + ctx->vram_dst, block, 16);
 
-    ctx.byte++;
+    ctx->vram_src += 16;
+    ctx->vram_dst = (ctx->vram_dst + 16) & 0x1FF0;
 
-    ctx.active = ctx.byte < 0xA0;
+    //8 cycles a block, twice as many at double speed.
+    ctx->stall += cpu_get_context()->double_speed ? 16 : 8;
 }
 
-bool dma_transferring() {
-    return ctx.active;
+u8 dma_vram_read(u16 address) {
+    if (address == 0xFF55) {
+        //bit 7 is set when no hblank transfer is running.
+        return ctx->vram_blocks | (ctx->hblank_active ? 0 : 0x80);
+    }
+
+    //the other registers are write only.
+    return 0xFF;
+}
+
+void dma_vram_write(u16 address, u8 value) {
+    switch(address) {
+        case 0xFF51:
+            ctx->vram_src = (ctx->vram_src & 0x00F0) | (value << 8);
+            break;
+
+        case 0xFF52:
+            ctx->vram_src = (ctx->vram_src & 0xFF00) | (value & 0xF0);
+            break;
+
+        case 0xFF53:
+            ctx->vram_dst = (ctx->vram_dst & 0x00F0) | ((value & 0x1F) << 8);
+            break;
+
+        case 0xFF54:
+            ctx->vram_dst = (ctx->vram_dst & 0x1F00) | (value & 0xF0);
+            break;
+
+        case 0xFF55:
+            if (ctx->hblank_active && !(value & 0x80)) {
+                //stops the hblank transfer, the blocks left stay readable.
+                ctx->hblank_active = false;
+                break;
+            }
+
+            ctx->vram_blocks = value & 0x7F;
+
+            if (value & 0x80) {
+                ctx->hblank_active = true;
+
+                if (!LCDC_LCD_ENABLE || LCDS_MODE == MODE_HBLANK) {
+                    //there is no hblank to wait for.
+                    dma_hblank();
+                }
+
+                break;
+            }
+
+            //general dma, the whole transfer at once.
+            for (int i=0; i<=ctx->vram_blocks; i++) {
+                vram_copy_block();
+            }
+
+            ctx->vram_blocks = 0x7F;
+            break;
+    }
+}
+
+void dma_hblank() {
+    if (!ctx->hblank_active) {
+        return;
+    }
+
+    vram_copy_block();
+
+    if (ctx->vram_blocks-- == 0) {
+        ctx->vram_blocks = 0x7F;
+        ctx->hblank_active = false;
+    }
+}
+
+u16 dma_take_stall() {
+    u16 stall = ctx->stall;
+    ctx->stall = 0;
+
+    return stall;
 }
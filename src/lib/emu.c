@@ -4,51 +4,362 @@
 #include <cpu.h>
 #include <ui.h>
 #include <timer.h>
-#include <dma.h>
 #include <ppu.h>
 #include <sound.h>
+#include <ppu_deferred.h>
+#include <state.h>
+#include <rewind.h>
+#include <runahead.h>
+#include <movie.h>
+#include <battery.h>
+#include <gbio.h>
+#include <link.h>
+#include <string.h>
 
 //TODO Add Windows Alternative...
 #include <pthread.h>
 #include <unistd.h>
 
-static emu_context ctx;
+static emu_context main_ctx;
+static _Thread_local emu_context *ctx = &main_ctx;
 pthread_t current_game;
 
+//--ppu-thread[=line|frame], render on a separate thread.
+static bool ppu_thread = false;
+static ppu_sync ppu_thread_sync = PPU_SYNC_FRAME;
+
+//frames are paced here, the core itself never looks at the clock.
+//a frame of the game boy's 4194304 Hz clock, 59.73 frames a second.
+static const double target_frame_time = 1000.0 * 154 * 456 / 4194304;
+static double next_frame_time = 0;
+static long start_timer = 0;
+static long frame_count = 0;
+u32 fps = 0;
+
+//--rewind[=MB], keep the last frames for rewinding within this budget.
+static u32 rewind_budget = 0;
+
+//--run-ahead[=frames], show the frame this many frames ahead.
+static int runahead_frames = 0;
+
+//--battery-sync=never|exit|always, when battery saves are forced to disk.
+static battery_sync battery_sync_policy = BATTERY_SYNC_ALWAYS;
+
+//--record=<file> / --play=<file>, input movie of this session.
+static char *movie_record_file = NULL;
+static char *movie_play_file = NULL;
+
+//--link-listen=<socket> / --link=<socket>, link cable to another gbemu.
+//Turns off run-ahead and rewind, and state loads while it is connected.
+static char *link_listen_path = NULL;
+static char *link_connect_path = NULL;
+
+//--audio=sdl|null / --wav=<file>, where the sound goes.
+static const sound_sink *audio_sink = &sound_sink_sdl;
+static sound_wav audio_wav;
+
 emu_context *emu_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void emu_set_context(emu_context *context) {
+    ctx = context;
+}
+
+//a connected cable's partner can't take back what a loaded state undoes.
+static void handle_state_request(bool linked) {
+    char fn[1048];
+    sprintf(fn, "%s.state", cart_get_context()->filename);
+
+    if (ctx->save_state) {
+        ctx->save_state = false;
+
+        if (state_save_file(fn)) {
+            printf("Saved state: %s\n", fn);
+        }
+    }
+
+    if (ctx->load_state) {
+        ctx->load_state = false;
+
+        if (movie_get_mode() != MOVIE_NONE) {
+            printf("Can't load a state while a movie is active\n");
+        } else if (linked) {
+            printf("Can't load a state while a link cable is connected\n");
+        } else if (state_load_file(fn)) {
+            printf("Loaded state: %s\n", fn);
+        }
+    }
+}
+
+static void start_movie() {
+    if (movie_play_file) {
+        if (movie_play_start(movie_play_file)) {
+            printf("Playing movie: %s (%u frames)\n", movie_play_file, movie_get_frames());
+        }
+    } else if (movie_record_file) {
+        movie_record_start(60);
+        printf("Recording movie: %s\n", movie_record_file);
+    }
+}
+
+static void check_movie() {
+    if (movie_get_mode() != MOVIE_PLAY || !movie_finished()) {
+        return;
+    }
+
+    if (movie_get_desyncs()) {
+        printf("Movie finished: %u frames, %u desyncs, first at frame %d\n",
+            movie_get_frames(), movie_get_desyncs(), movie_first_desync());
+    } else {
+        printf("Movie finished: %u frames, in sync\n", movie_get_frames());
+    }
+
+    movie_stop();
+}
+
+static void print_io_stats() {
+    const io_stats *stats = io_get_stats();
+
+    //what the game touched that isn't emulated.
+    for (int i=0; i<IO_REGISTERS; i++) {
+        if (stats->unmapped_reads[i] || stats->unmapped_writes[i]) {
+            printf("Unmapped IO FF%02X: %u reads, %u writes\n", i,
+                stats->unmapped_reads[i], stats->unmapped_writes[i]);
+        }
+    }
+}
+
+//the frames keep to the game boy's own rate, the audio device plays what
+//the apu makes at that rate and never holds the emulation back.
+static void frame_pacing() {
+    if (ctx->fast_forward) {
+        next_frame_time = 0;
+        return;
+    }
+
+    //calc FPS...
+    u64 end = get_ticks();
+
+    //deadlines add up, frames of 16.74 ms don't round to whole ms. After a
+    //pause or a slow frame the pace starts over instead of catching up.
+    if (!next_frame_time || end > next_frame_time + target_frame_time * 4) {
+        next_frame_time = end;
+    }
+
+    next_frame_time += target_frame_time;
+
+    if (next_frame_time > end) {
+        delay(next_frame_time - end);
+    }
+
+    if (end - start_timer >= 1000) {
+        fps = frame_count;
+        start_timer = end;
+        frame_count = 0;
+    }
+
+    frame_count++;
 }
 
 void *cpu_run(void *p) {
     timer_init();
     cpu_init();
 	ppu_init();
+    sound_set_sink(audio_sink, &audio_wav);
     sound_init(0, 0);
+    io_reset_stats();
+
+    //what speculative and replayed frames send over the cable can't be taken back.
+    if ((link_listen_path || link_connect_path) && runahead_frames) {
+        printf("--run-ahead is ignored with --link\n");
+        runahead_frames = 0;
+    }
+
+    if ((link_listen_path || link_connect_path) && rewind_budget) {
+        printf("--rewind is ignored with --link\n");
+        rewind_budget = 0;
+    }
+
+    if (ppu_thread && runahead_frames) {
+        printf("--ppu-thread is ignored with --run-ahead\n");
+    } else if (ppu_thread) {
+        ppu_deferred_start(ppu_thread_sync);
+    }
+
+    runahead_set_frames(runahead_frames);
+
+    ctx->running = true;
+    ctx->paused = false;
+
+    //the cartridge clock was anchored to the ticks when it was loaded.
+    u64 clock = mbc_rtc_get_clock();
+    ctx->ticks = 0;
+    mbc_rtc_set_clock(clock);
+
+    ctx->save_state = false;
+    ctx->load_state = false;
+    ctx->rewinding = false;
+
+    if (rewind_budget) {
+        rewind_init(rewind_budget);
+    }
+
+    start_movie();
+    battery_start(battery_sync_policy);
 
-    ctx.running = true;
-    ctx.paused = false;
-    ctx.ticks = 0;
+    link_cable *cable = NULL;
 
-    while(ctx.running) {
-        if (ctx.paused) {
+    if (link_listen_path) {
+        cable = link_listen(link_listen_path);
+    } else if (link_connect_path) {
+        cable = link_connect(link_connect_path);
+    }
+
+    u32 prev_frame = ppu_get_context()->current_frame;
+
+    while(ctx->running) {
+        if (ctx->paused) {
             delay(10);
             continue;
         }
 
+        if (ctx->save_state || ctx->load_state) {
+            handle_state_request(cable != NULL);
+        }
+
+        if (ctx->rewinding && rewind_enabled() && movie_get_mode() == MOVIE_NONE) {
+            //counted as a new frame, so the loaded picture is presented.
+            ppu_get_context()->current_frame++;
+
+            if (!rewind_step_back()) {
+                ppu_get_context()->current_frame--;
+            }
+
+            prev_frame = ppu_get_context()->current_frame;
+            delay(1000 / 60);
+            continue;
+        }
+
         if (!cpu_step()) {
             printf("CPU Stopped\n");
-            return 0;
+            break;
+        }
+
+        if (cable && !link_poll(cable)) {
+            printf("Link cable disconnected\n");
+            link_free(cable);
+            cable = NULL;
+        }
+
+        if (prev_frame != ppu_get_context()->current_frame) {
+            frame_pacing();
+            movie_frame();
+            check_movie();
+            rewind_push();
+            battery_frame();
+
+            if (!runahead_speculate()) {
+                printf("CPU Stopped\n");
+                break;
+            }
+
+            prev_frame = ppu_get_context()->current_frame;
         }
     }
 
+    runahead_free();
+
+    if (cable) {
+        link_stats stats;
+        link_get_stats(cable, &stats);
+
+        printf("Link: %u transfers, %u rollbacks\n", stats.transfers, stats.rollbacks);
+        link_free(cable);
+    }
+
+    if (movie_get_mode() == MOVIE_RECORD) {
+        movie_stop();
+
+        if (movie_save(movie_record_file)) {
+            printf("Saved movie: %s (%u frames)\n", movie_record_file, movie_get_frames());
+        }
+    }
+
+    movie_stop();
+
+    if (rewind_enabled()) {
+        rewind_stats stats;
+        rewind_get_stats(&stats);
+
+        printf("Rewind: %u frames (%.1f s) in %u KB, %.1f KB/s, push %.1f us, step back %.1f us\n",
+            stats.frames, stats.seconds, stats.bytes_used / 1024, stats.bytes_per_second / 1024,
+            stats.encode_us, stats.decode_us);
+        rewind_free();
+    }
+
+    ppu_deferred_stop();
+    battery_stop();
+    print_io_stats();
+
+    audio_ring_stats audio;
+    sound_get_stats(&audio);
+
+    if (audio.underruns || audio.overruns) {
+        printf("Audio: %u underruns (%llu frames of silence), %u overruns (%llu frames dropped)\n",
+            audio.underruns, (unsigned long long)audio.silent_frames,
+            audio.overruns, (unsigned long long)audio.dropped_frames);
+    }
+
+    sound_close();
+
     return 0;
 }
 
 int emu_run(int argc, char **argv) {
+    for (int i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "--ppu-thread") || !strcmp(argv[i], "--ppu-thread=frame")) {
+            ppu_thread = true;
+            ppu_thread_sync = PPU_SYNC_FRAME;
+        } else if (!strcmp(argv[i], "--ppu-thread=line")) {
+            ppu_thread = true;
+            ppu_thread_sync = PPU_SYNC_LINE;
+        } else if (!strcmp(argv[i], "--rewind")) {
+            rewind_budget = 16 * 1024 * 1024;
+        } else if (!strncmp(argv[i], "--rewind=", 9)) {
+            rewind_budget = atoi(argv[i] + 9) * 1024 * 1024;
+        } else if (!strcmp(argv[i], "--run-ahead")) {
+            runahead_frames = 1;
+        } else if (!strncmp(argv[i], "--run-ahead=", 12)) {
+            runahead_frames = atoi(argv[i] + 12);
+        } else if (!strncmp(argv[i], "--record=", 9)) {
+            movie_record_file = argv[i] + 9;
+        } else if (!strncmp(argv[i], "--play=", 7)) {
+            movie_play_file = argv[i] + 7;
+        } else if (!strncmp(argv[i], "--link-listen=", 14)) {
+            link_listen_path = argv[i] + 14;
+        } else if (!strncmp(argv[i], "--link=", 7)) {
+            link_connect_path = argv[i] + 7;
+        } else if (!strcmp(argv[i], "--audio=sdl")) {
+            audio_sink = &sound_sink_sdl;
+        } else if (!strcmp(argv[i], "--audio=null")) {
+            audio_sink = &sound_sink_null;
+        } else if (!strncmp(argv[i], "--wav=", 6)) {
+            audio_sink = &sound_sink_wav;
+            audio_wav.path = argv[i] + 6;
+        } else if (!strcmp(argv[i], "--battery-sync=never")) {
+            battery_sync_policy = BATTERY_SYNC_NEVER;
+        } else if (!strcmp(argv[i], "--battery-sync=exit")) {
+            battery_sync_policy = BATTERY_SYNC_EXIT;
+        } else if (!strcmp(argv[i], "--battery-sync=always")) {
+            battery_sync_policy = BATTERY_SYNC_ALWAYS;
+        }
+    }
+
     ui_init();
-    ctx.die = false;
+    ctx->die = false;
     u32 prev_frame = 0;
-    while (!ctx.die) {
+    while (!ctx->die) {
         usleep(1000);
         ui_handle_events();
 
@@ -58,17 +369,24 @@ int emu_run(int argc, char **argv) {
         prev_frame = ppu_get_context()->current_frame;
     }
 
-    ctx.die = true;
+    ctx->die = true;
+
+    //let the cpu thread finish, it saves the recorded movie.
+    if (current_game) {
+        ctx->running = false;
+        pthread_join(current_game, NULL);
+    }
+
     return 0;
 }
 
 int run_game(char *romfile) {
-    ctx.running = false;
-    usleep(1000);
+    ctx->running = false;
 
+    //the old game's rom is unmapped by the load.
     if (current_game) {
-        //pthread_kill(current_game, 9);
-        usleep(1000);
+        pthread_join(current_game, NULL);
+        current_game = 0;
     }
 
     if (!cart_load(romfile)) {
@@ -84,15 +402,46 @@ int run_game(char *romfile) {
     return 0;
 }
 
+//a cgb in double speed clocks the cpu, timer and dma twice as fast. the
+//ppu and apu keep their clock, so they get half the ticks per m-cycle.
+static void emu_cycles_double(int cpu_cycles) {
+    ctx->cycles += cpu_cycles;
+
+    for (int i=0; i<cpu_cycles; i++) {
+        for (int n=0; n<2; n++) {
+            ctx->ticks++;
+            timer_tick();
+            timer_tick();
+            ppu_tick();
+        }
+
+        sound_tick(1);
+    }
+
+    if (ctx->next_event && ctx->cycles >= ctx->next_event) {
+        scheduler_run();
+    }
+}
+
 void emu_cycles(int cpu_cycles) {
+    if (cpu_get_context()->double_speed) {
+        emu_cycles_double(cpu_cycles);
+        return;
+    }
+
+    ctx->cycles += cpu_cycles;
+
     for (int i=0; i<cpu_cycles; i++) {
         for (int n=0; n<4; n++) {
-            ctx.ticks++;
+            ctx->ticks++;
             timer_tick();
             ppu_tick();
         }
         
         sound_tick(2);
-        dma_tick();
+    }
+
+    if (ctx->next_event && ctx->cycles >= ctx->next_event) {
+        scheduler_run();
     }
 }
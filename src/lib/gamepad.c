@@ -1,52 +1,85 @@
 #include <gamepad.h>
 #include <string.h>
 
-static gamepad_context ctx = {0};
+static gamepad_context main_ctx;
+static _Thread_local gamepad_context *ctx = &main_ctx;
 
 gamepad_context *gamepad_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void gamepad_set_context(gamepad_context *context) {
+    ctx = context;
 }
 
 bool gamepad_button_sel() {
-    return ctx.button_sel;
+    return ctx->button_sel;
 }
 
 bool gamepad_dir_sel() {
-    return ctx.dir_sel;
+    return ctx->dir_sel;
 }
 
 void gamepad_set_sel(u8 value) {
-    ctx.button_sel = value & 0x20;
-    ctx.dir_sel = value & 0x10;
+    ctx->button_sel = value & 0x20;
+    ctx->dir_sel = value & 0x10;
 }
 
 gamepad_state *gamepad_get_state() {
-    return &ctx.controller;
+    return ctx->latched ? &ctx->input : &ctx->controller;
+}
+
+void gamepad_set_latched(bool latched) {
+    if (latched && !ctx->latched) {
+        ctx->input = ctx->controller;
+    } else if (!latched && ctx->latched) {
+        ctx->controller = ctx->input;
+    }
+
+    ctx->latched = latched;
+}
+
+u8 gamepad_pack(gamepad_state *state) {
+    return (state->a ? GAMEPAD_A : 0) | (state->b ? GAMEPAD_B : 0) |
+        (state->select ? GAMEPAD_SELECT : 0) | (state->start ? GAMEPAD_START : 0) |
+        (state->right ? GAMEPAD_RIGHT : 0) | (state->left ? GAMEPAD_LEFT : 0) |
+        (state->up ? GAMEPAD_UP : 0) | (state->down ? GAMEPAD_DOWN : 0);
+}
+
+void gamepad_unpack(u8 buttons, gamepad_state *state) {
+    state->a = buttons & GAMEPAD_A;
+    state->b = buttons & GAMEPAD_B;
+    state->select = buttons & GAMEPAD_SELECT;
+    state->start = buttons & GAMEPAD_START;
+    state->right = buttons & GAMEPAD_RIGHT;
+    state->left = buttons & GAMEPAD_LEFT;
+    state->up = buttons & GAMEPAD_UP;
+    state->down = buttons & GAMEPAD_DOWN;
 }
 
 u8 gamepad_get_output() {
     u8 output = 0xCF;
 
     if (!gamepad_button_sel()) {
-        if (gamepad_get_state()->start) {
+        if (ctx->controller.start) {
             output &= ~(1 << 3);
-        } else if (gamepad_get_state()->select) {
+        } else if (ctx->controller.select) {
             output &= ~(1 << 2);
-        } else if (gamepad_get_state()->a) {
+        } else if (ctx->controller.a) {
             output &= ~(1 << 0);
-        } else if (gamepad_get_state()->b) {
+        } else if (ctx->controller.b) {
             output &= ~(1 << 1);
         }
     }
 
     if (!gamepad_dir_sel()) {
-        if (gamepad_get_state()->left) {
+        if (ctx->controller.left) {
             output &= ~(1 << 1);
-        } else if (gamepad_get_state()->right) {
+        } else if (ctx->controller.right) {
             output &= ~(1 << 0);
-        } else if (gamepad_get_state()->up) {
+        } else if (ctx->controller.up) {
             output &= ~(1 << 2);
-        } else if (gamepad_get_state()->down) {
+        } else if (ctx->controller.down) {
             output &= ~(1 << 3);
         }
     }
@@ -5,77 +5,156 @@
 #include <lcd.h>
 #include <gamepad.h>
 #include <sound.h>
+#include <ram.h>
+#include <cart.h>
+#include <serial.h>
+#include <string.h>
 
-static char serial_data[2];
+static io_context main_ctx;
+static _Thread_local io_context *ctx = &main_ctx;
 
-u8 io_read(u16 address) {
-    if (address == 0xFF00) {
-        return gamepad_get_output();
-    }
+io_context *io_get_context() {
+    return ctx;
+}
 
-    if (address == 0xFF01) {
-        return serial_data[0];
-    }
+void io_set_context(io_context *context) {
+    ctx = context;
+}
 
-    if (address == 0xFF02) {
-        return serial_data[1];
-    }
+typedef u8 (*io_read_fn)(u16 address);
+typedef void (*io_write_fn)(u16 address, u8 value);
 
-    if (BETWEEN(address, 0xFF04, 0xFF07)) {
-        return timer_read(address);
-    }
+typedef struct {
+    io_read_fn read;
+    io_write_fn write;
+    u8 read_mask; //bits the register doesn't have, they read as 1.
+    bool cgb; //only there in color mode.
+} io_register;
 
-    if (address == 0xFF0F) {
-        return cpu_get_int_flags();
-    }
+static u8 joyp_read(u16 address) {
+    return gamepad_get_output();
+}
+
+static void joyp_write(u16 address, u8 value) {
+    gamepad_set_sel(value);
+}
+
+static u8 if_read(u16 address) {
+    return cpu_get_int_flags();
+}
+
+static void if_write(u16 address, u8 value) {
+    cpu_set_int_flags(value);
+}
+
+static u8 key1_read(u16 address) {
+    return cpu_key1_read();
+}
+
+static void key1_write(u16 address, u8 value) {
+    cpu_key1_write(value);
+}
+
+static u8 svbk_read(u16 address) {
+    return ram_svbk_read();
+}
+
+static void svbk_write(u16 address, u8 value) {
+    ram_svbk_write(value);
+}
 
-    if (BETWEEN(address, 0xFF10, 0xFF3F)) {
-        return sound_read(address);
+//write only or unused, but there. reads as FF and writes are dropped.
+static u8 open_read(u16 address) {
+    return 0xFF;
+}
+
+static void ignore_write(u16 address, u8 value) {
+}
+
+#define TIMER { timer_read, timer_write, 0 }
+#define SOUND(mask) { sound_read, sound_write, mask }
+#define LCD { lcd_read, lcd_write, 0 }
+
+static const io_register registers[IO_REGISTERS] = {
+    [0x00] = { joyp_read, joyp_write, 0xC0 },
+    [0x01] = { serial_read, serial_write, 0 },
+    [0x02] = { serial_read, serial_write, 0x7C },
+    [0x04] = TIMER,
+    [0x05] = TIMER,
+    [0x06] = TIMER,
+    [0x07] = { timer_read, timer_write, 0xF8 },
+    [0x0F] = { if_read, if_write, 0xE0 },
+
+    [0x10] = SOUND(0x80), [0x11] = SOUND(0x3F), [0x12] = SOUND(0x00), [0x13] = SOUND(0xFF),
+    [0x14] = SOUND(0xBF), [0x15] = SOUND(0xFF), [0x16] = SOUND(0x3F), [0x17] = SOUND(0x00),
+    [0x18] = SOUND(0xFF), [0x19] = SOUND(0xBF), [0x1A] = SOUND(0x7F), [0x1B] = SOUND(0xFF),
+    [0x1C] = SOUND(0x9F), [0x1D] = SOUND(0xFF), [0x1E] = SOUND(0xBF), [0x1F] = SOUND(0xFF),
+    [0x20] = SOUND(0xFF), [0x21] = SOUND(0x00), [0x22] = SOUND(0x00), [0x23] = SOUND(0xBF),
+    [0x24] = SOUND(0x00), [0x25] = SOUND(0x00), [0x26] = SOUND(0x70),
+    [0x30 ... 0x3F] = SOUND(0x00), //wave ram
+
+    [0x40] = LCD,
+    [0x41] = { lcd_read, lcd_write, 0x80 },
+    [0x42 ... 0x4B] = LCD,
+
+    [0x4D] = { key1_read, key1_write, 0x7E, true },
+    [0x4F] = { lcd_read, lcd_write, 0xFE, true },
+    [0x50] = { open_read, ignore_write, 0xFF }, //boot rom off, there is no boot rom.
+    [0x51 ... 0x54] = { dma_vram_read, dma_vram_write, 0xFF, true },
+    [0x55] = { dma_vram_read, dma_vram_write, 0, true },
+    [0x68] = { lcd_read, lcd_write, 0x40, true },
+    [0x69] = { lcd_read, lcd_write, 0, true },
+    [0x6A] = { lcd_read, lcd_write, 0x40, true },
+    [0x6B] = { lcd_read, lcd_write, 0, true },
+    [0x70] = { svbk_read, svbk_write, 0xF8, true },
+};
+
+static inline const io_register *io_register_at(u16 address) {
+    const io_register *r = &registers[address & (IO_REGISTERS - 1)];
+
+    if (!r->read || (r->cgb && !cart_cgb())) {
+        return NULL;
     }
 
-    if (BETWEEN(address, 0xFF40, 0xFF4B)) {
-        return lcd_read(address);
+    return r;
+}
+
+u8 io_read(u16 address) {
+    const io_register *r = io_register_at(address);
+
+    if (!r) {
+        ctx->stats.unmapped_reads[address & (IO_REGISTERS - 1)]++;
+        return 0xFF;
     }
 
-    printf("UNSUPPORTED bus_read(%04X)\n", address);
-    return 0;
+    return r->read(address) | r->read_mask;
 }
 
 void io_write(u16 address, u8 value) {
-    if (address == 0xFF00) {
-        gamepad_set_sel(value);
-        return;
-    }
+    const io_register *r = io_register_at(address);
 
-    if (address == 0xFF01) {
-        serial_data[0] = value;
+    if (!r) {
+        ctx->stats.unmapped_writes[address & (IO_REGISTERS - 1)]++;
         return;
     }
 
-    if (address == 0xFF02) {
-        serial_data[1] = value;
-        return;
-    }
+    r->write(address, value);
+}
 
-    if (BETWEEN(address, 0xFF04, 0xFF07)) {
-        timer_write(address, value);
-        return;
-    }
+const io_stats *io_get_stats() {
+    return &ctx->stats;
+}
 
-    if (address == 0xFF0F) {
-        cpu_set_int_flags(value);
-        return;
-    }
+void io_reset_stats() {
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
 
-    if (BETWEEN(address, 0xFF10, 0xFF3F)) {
-        sound_write(address, value);
-        return;
-    }
+u32 io_unmapped_total() {
+    u32 total = 0;
 
-    if (BETWEEN(address, 0xFF40, 0xFF4B)) {
-        lcd_write(address, value);
-        return;
+    for (int i=0; i<IO_REGISTERS; i++) {
+        total += ctx->stats.unmapped_reads[i] + ctx->stats.unmapped_writes[i];
     }
 
-    printf("UNSUPPORTED bus_write(%04X)\n", address);
+    return total;
 }
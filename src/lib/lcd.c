@@ -1,50 +1,139 @@
 #include <lcd.h>
 #include <ppu.h>
 #include <dma.h>
+#include <ppu_deferred.h>
+#include <cart.h>
+#include <string.h>
 
-static lcd_context ctx;
+static lcd_context main_ctx;
+
+//see ppu_set_context, the deferred ppu render thread has its own lcd.
+static _Thread_local lcd_context *ctx = &main_ctx;
 
 static unsigned long colors_default[4] = {0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000}; 
 
+static void update_cgb_color(u8 *palette_ram, u32 (*colors)[4], u8 index) {
+    u16 c = palette_ram[index & ~1] | (palette_ram[index | 1] << 8);
+    u8 r = c & 0x1F;
+    u8 g = (c >> 5) & 0x1F;
+    u8 b = (c >> 10) & 0x1F;
+
+    //5 bits to 8, the top bits fill the bottom so 1F is FF.
+    colors[index >> 3][(index >> 1) & 0b11] = 0xFF000000 |
+        ((r << 3 | r >> 2) << 16) | ((g << 3 | g >> 2) << 8) | (b << 3 | b >> 2);
+}
+
 void lcd_init() {
-    ctx.lcdc = 0x91;
-    ctx.scroll_x = 0;
-    ctx.scroll_y = 0;
-    ctx.ly = 0;
-    ctx.ly_compare = 0;
-    ctx.bg_palette = 0xFC;
-    ctx.obj_palette[0] = 0xFF;
-    ctx.obj_palette[1] = 0xFF;
-    ctx.win_y = 0;
-    ctx.win_x = 0;
+    ctx->lcdc = 0x91;
+    ctx->scroll_x = 0;
+    ctx->scroll_y = 0;
+    ctx->ly = 0;
+    ctx->ly_compare = 0;
+    ctx->bg_palette = 0xFC;
+    ctx->obj_palette[0] = 0xFF;
+    ctx->obj_palette[1] = 0xFF;
+    ctx->win_y = 0;
+    ctx->win_x = 0;
 
     for (int i=0; i<4; i++) {
-        ctx.bg_colors[i] = colors_default[i];
-        ctx.sp1_colors[i] = colors_default[i];
-        ctx.sp2_colors[i] = colors_default[i];
+        ctx->bg_colors[i] = colors_default[i];
+        ctx->sp1_colors[i] = colors_default[i];
+        ctx->sp2_colors[i] = colors_default[i];
+    }
+
+    ctx->cgb = cart_cgb();
+    ctx->vbk = 0;
+    ctx->bcps = 0;
+    ctx->ocps = 0;
+
+    //without a boot rom the palettes start out white.
+    memset(ctx->bg_palette_ram, 0xFF, sizeof(ctx->bg_palette_ram));
+    memset(ctx->obj_palette_ram, 0xFF, sizeof(ctx->obj_palette_ram));
+
+    lcd_update_cgb_colors();
+}
+
+void lcd_update_cgb_colors() {
+    for (int i=0; i<64; i += 2) {
+        update_cgb_color(ctx->bg_palette_ram, ctx->bg_cgb_colors, i);
+        update_cgb_color(ctx->obj_palette_ram, ctx->sp_cgb_colors, i);
     }
 }
 
 lcd_context *lcd_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void lcd_set_context(lcd_context *context) {
+    ctx = context;
+}
+
+static u8 cgb_read(u16 address) {
+    switch(address) {
+        case 0xFF4F: return ctx->vbk;
+        case 0xFF68: return ctx->bcps;
+        case 0xFF69: return ctx->bg_palette_ram[ctx->bcps & 0x3F];
+        case 0xFF6A: return ctx->ocps;
+        case 0xFF6B: return ctx->obj_palette_ram[ctx->ocps & 0x3F];
+    }
+
+    return 0xFF;
+}
+
+static void cgb_write(u16 address, u8 value) {
+    switch(address) {
+        case 0xFF4F:
+            ctx->vbk = value & 1;
+            break;
+
+        case 0xFF68:
+            ctx->bcps = value & 0xBF;
+            break;
+
+        case 0xFF69:
+            ctx->bg_palette_ram[ctx->bcps & 0x3F] = value;
+            update_cgb_color(ctx->bg_palette_ram, ctx->bg_cgb_colors, ctx->bcps & 0x3F);
+
+            if (ctx->bcps & 0x80) {
+                ctx->bcps = 0x80 | ((ctx->bcps + 1) & 0x3F);
+            }
+            break;
+
+        case 0xFF6A:
+            ctx->ocps = value & 0xBF;
+            break;
+
+        case 0xFF6B:
+            ctx->obj_palette_ram[ctx->ocps & 0x3F] = value;
+            update_cgb_color(ctx->obj_palette_ram, ctx->sp_cgb_colors, ctx->ocps & 0x3F);
+
+            if (ctx->ocps & 0x80) {
+                ctx->ocps = 0x80 | ((ctx->ocps + 1) & 0x3F);
+            }
+            break;
+    }
 }
 
 u8 lcd_read(u16 address) {
+    if (address > 0xFF4B) {
+        return cgb_read(address);
+    }
+
     u8 offset = (address - 0xFF40);
-    u8 *p = (u8 *)&ctx;
+    u8 *p = (u8 *)ctx;
 
     return p[offset];
 }
 
 void update_palette(u8 palette_data, u8 pal) {
-    u32 *p_colors = ctx.bg_colors;
+    u32 *p_colors = ctx->bg_colors;
 
     switch(pal) {
         case 1:
-            p_colors = ctx.sp1_colors;
+            p_colors = ctx->sp1_colors;
             break;
         case 2:
-            p_colors = ctx.sp2_colors;
+            p_colors = ctx->sp2_colors;
             break;
     }
 
@@ -57,9 +146,29 @@ void update_palette(u8 palette_data, u8 pal) {
 void lcd_write(u16 address, u8 value) {
 
     u8 offset = (address - 0xFF40);
-    u8 *p = (u8 *)&ctx;
+    if (ppu_get_context()->deferred && address != 0xFF46) {
+        //replayed by the render thread, the dma writes are logged by oam.
+        ppu_deferred_log(address, value);
+    }
+
+    if (address > 0xFF4B) {
+        cgb_write(address, value);
+        return;
+    }
+
+    u8 *p = (u8 *)ctx;
+    bool was_enabled = LCDC_LCD_ENABLE;
     p[offset] = value;
 
+    if (offset == 0 && was_enabled != LCDC_LCD_ENABLE) {
+        //0xFF40 = LCDC, bit 7 switches the lcd on/off
+        if (LCDC_LCD_ENABLE) {
+            ppu_lcd_enable();
+        } else {
+            ppu_lcd_disable();
+        }
+    }
+
     if (offset == 6) { 
         //0xFF46 = DMA
         dma_start(value);
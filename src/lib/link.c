@@ -0,0 +1,617 @@
+#include <link.h>
+#include <serial.h>
+#include <state.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef enum {
+    MSG_READY, //a transfer waits for our clock, data is SB.
+    MSG_IDLE, //nothing waits anymore.
+    MSG_BYTE, //we clocked transfer seq, data is what we shifted out.
+    MSG_ANSWER, //data is what was shifted out for transfer seq.
+    MSG_SYNC, //send MSG_TIME with the same seq once your time gets here.
+    MSG_TIME //our time got there.
+} link_msg_type;
+
+typedef struct {
+    u64 time; //ticks since the cable was plugged in.
+    u16 seq;
+    u8 type;
+    u8 data;
+    u32 unused;
+} link_msg;
+
+//one end of the in-process cable.
+typedef struct link_port {
+    machine *m;
+    struct link_port *other;
+    u64 start; //the machine's ticks when it was plugged in.
+    bool failed;
+
+    //published at every barrier, for the other side's transfers.
+    u8 sb;
+    bool waiting;
+
+    //clocked out during the quantum, delivered at the barrier.
+    bool pending;
+    u8 out;
+    u32 transfers;
+} link_port;
+
+struct link_cable {
+    bool local;
+    link_stats stats;
+
+    //in process.
+    link_port ports[2];
+    int threads;
+    u64 time;
+    u64 end;
+    bool failed;
+    bool exit;
+    pthread_t worker;
+    pthread_barrier_t barrier;
+
+    //between processes.
+    int fd;
+    bool connected;
+    u8 rx[sizeof(link_msg) * 64];
+    u32 rx_size;
+    u64 start;
+    u64 last_poll;
+
+    bool announced_waiting;
+    u8 announced_sb;
+    bool remote_waiting;
+    u8 remote_sb;
+
+    //ours, the last one the partner got to.
+    u16 sync_seq;
+    u16 synced_seq;
+
+    //the partner's.
+    bool sync_requested;
+    u64 sync_time;
+    u16 sync_request_seq;
+    u64 taken_time;
+
+    //the transfer that finished during the last step.
+    bool completed;
+    u8 out;
+    u8 prediction;
+    u16 seq;
+
+    //the transfer whose answer is awaited, and the state right after it.
+    bool outstanding;
+    u16 spec_seq;
+    u8 spec_prediction;
+    u8 *spec_state;
+    u32 spec_size;
+    u32 spec_capacity;
+    u64 spec_ticks;
+
+    bool rollback;
+    u8 rollback_value;
+
+    //a byte the partner clocked at a time this side hasn't reached yet.
+    bool incoming;
+    link_msg incoming_msg;
+
+    //bytes the partner clocked in after the saved state, taken again after a rollback.
+    u8 replay[16];
+    int replay_count;
+};
+
+static void publish(link_port *port) {
+    port->sb = serial_get_context()->sb;
+    port->waiting = serial_waiting();
+}
+
+static u8 local_sink(u8 out, void *user) {
+    link_port *port = user;
+
+    port->pending = true;
+    port->out = out;
+    port->transfers++;
+
+    return port->other->waiting ? port->other->sb : 0xFF;
+}
+
+static bool run_port(link_port *port, u64 time) {
+    emu_context *emu = emu_get_context();
+
+    while (emu->ticks - port->start < time) {
+        if (!cpu_step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//both machines are stopped at the barrier, the calling thread ends up bound to the first.
+static void exchange(link_cable *l) {
+    for (int i=0; i<2; i++) {
+        link_port *from = &l->ports[i];
+
+        if (from->pending) {
+            machine_bind(from->other->m);
+            serial_external(from->out);
+            from->pending = false;
+        }
+    }
+
+    for (int i=1; i>=0; i--) {
+        machine_bind(l->ports[i].m);
+        publish(&l->ports[i]);
+    }
+
+    l->failed = l->ports[0].failed || l->ports[1].failed;
+}
+
+static void run_side(link_cable *l, int side) {
+    link_port *port = &l->ports[side];
+
+    while (l->time < l->end && !l->failed) {
+        u64 time = l->time + LINK_QUANTUM < l->end ? l->time + LINK_QUANTUM : l->end;
+
+        machine_bind(port->m);
+        port->failed = !run_port(port, time);
+
+        pthread_barrier_wait(&l->barrier);
+
+        if (side == 0) {
+            exchange(l);
+            l->time = time;
+        }
+
+        pthread_barrier_wait(&l->barrier);
+    }
+}
+
+static void *worker_run(void *p) {
+    link_cable *l = p;
+
+    while (true) {
+        pthread_barrier_wait(&l->barrier);
+
+        if (l->exit) {
+            return 0;
+        }
+
+        run_side(l, 1);
+    }
+}
+
+link_cable *link_local(machine *a, machine *b, int threads) {
+    link_cable *l = calloc(1, sizeof(link_cable));
+    machine *m[2] = {a, b};
+
+    l->local = true;
+    l->threads = threads == 2 ? 2 : 1;
+
+    for (int i=1; i>=0; i--) {
+        link_port *port = &l->ports[i];
+
+        port->m = m[i];
+        port->other = &l->ports[!i];
+
+        machine_bind(m[i]);
+        port->start = emu_get_context()->ticks;
+        serial_set_sink(local_sink, port);
+        publish(port);
+    }
+
+    if (l->threads == 2) {
+        pthread_barrier_init(&l->barrier, NULL, 2);
+
+        if (pthread_create(&l->worker, NULL, worker_run, l)) {
+            fprintf(stderr, "FAILED TO START LINK WORKER THREAD!\n");
+            exit(-1);
+        }
+    }
+
+    return l;
+}
+
+bool link_run(link_cable *l, u32 ticks) {
+    l->end = l->time + ticks;
+
+    if (l->threads == 2) {
+        pthread_barrier_wait(&l->barrier);
+        run_side(l, 0);
+    } else {
+        while (l->time < l->end && !l->failed) {
+            u64 time = l->time + LINK_QUANTUM < l->end ? l->time + LINK_QUANTUM : l->end;
+
+            for (int i=0; i<2; i++) {
+                machine_bind(l->ports[i].m);
+                l->ports[i].failed = !run_port(&l->ports[i], time);
+            }
+
+            exchange(l);
+            l->time = time;
+        }
+    }
+
+    machine_bind(l->ports[0].m);
+    return !l->failed;
+}
+
+void link_restart(link_cable *l) {
+    for (int i=1; i>=0; i--) {
+        link_port *port = &l->ports[i];
+
+        machine_bind(port->m);
+        port->start = emu_get_context()->ticks;
+        port->pending = false;
+        publish(port);
+    }
+
+    l->time = 0;
+    l->failed = false;
+}
+
+static u64 link_time(link_cable *l) {
+    return emu_get_context()->ticks - l->start;
+}
+
+static void send_msg(link_cable *l, u8 type, u8 data, u16 seq) {
+    link_msg msg = { link_time(l), seq, type, data, 0 };
+
+    if (l->connected && send(l->fd, &msg, sizeof(msg), MSG_NOSIGNAL) != sizeof(msg)) {
+        l->connected = false;
+    }
+}
+
+static void handle_msg(link_cable *l, const link_msg *msg) {
+    switch (msg->type) {
+        case MSG_READY:
+            l->remote_waiting = true;
+            l->remote_sb = msg->data;
+            break;
+
+        case MSG_IDLE:
+            l->remote_waiting = false;
+            break;
+
+        case MSG_BYTE:
+            //taken once this side's time gets there, see link_poll.
+            l->incoming = true;
+            l->incoming_msg = *msg;
+            break;
+
+        case MSG_ANSWER:
+            if (!l->outstanding || msg->seq != l->spec_seq) {
+                break;
+            }
+
+            if (msg->data == l->spec_prediction) {
+                l->outstanding = false;
+                l->replay_count = 0;
+            } else {
+                l->rollback = true;
+                l->rollback_value = msg->data;
+            }
+
+            break;
+
+        case MSG_SYNC:
+            l->sync_requested = true;
+            l->sync_time = msg->time;
+            l->sync_request_seq = msg->seq;
+            break;
+
+        case MSG_TIME:
+            l->synced_seq = msg->seq;
+            break;
+    }
+}
+
+//one read of the socket, false if nothing arrived.
+static bool receive(link_cable *l, bool block) {
+    if (!l->connected) {
+        return false;
+    }
+
+    ssize_t n = recv(l->fd, l->rx + l->rx_size, sizeof(l->rx) - l->rx_size, block ? 0 : MSG_DONTWAIT);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return false;
+    }
+
+    if (n <= 0) {
+        //the other side went away, the port is unplugged from now on.
+        l->connected = false;
+        l->remote_waiting = false;
+        l->outstanding = false;
+        return false;
+    }
+
+    l->rx_size += n;
+
+    u32 pos = 0;
+
+    for (; l->rx_size - pos >= sizeof(link_msg); pos += sizeof(link_msg)) {
+        link_msg msg;
+        memcpy(&msg, l->rx + pos, sizeof(msg));
+        handle_msg(l, &msg);
+    }
+
+    memmove(l->rx, l->rx + pos, l->rx_size - pos);
+    l->rx_size -= pos;
+
+    return true;
+}
+
+//the partner's byte for a transfer it clocked, answered with ours.
+static void take_incoming(link_cable *l) {
+    bool taken = serial_waiting();
+    u8 out = serial_external(l->incoming_msg.data);
+
+    if (taken) {
+        l->taken_time = link_time(l);
+
+        if (l->outstanding && l->replay_count < (int)sizeof(l->replay)) {
+            l->replay[l->replay_count++] = l->incoming_msg.data;
+        }
+    }
+
+    l->incoming = false;
+    send_msg(l, MSG_ANSWER, out, l->incoming_msg.seq);
+}
+
+//like the in-process cable, a byte that was taken leaves the game a
+//quantum to get ready for the next before the partner predicts it. A
+//stalled side's time doesn't move, it answers right away.
+static void check_sync(link_cable *l, bool stalled) {
+    u64 time = link_time(l);
+
+    if (!l->sync_requested || l->incoming || time < l->sync_time) {
+        return;
+    }
+
+    if (stalled || time >= l->taken_time + LINK_QUANTUM) {
+        l->sync_requested = false;
+        send_msg(l, MSG_TIME, 0, l->sync_request_seq);
+    }
+}
+
+static u8 socket_sink(u8 out, void *user) {
+    link_cable *l = user;
+
+    //waiting anyway, so also wait for the partner to catch up, what it
+    //announced by then is what it has now and the prediction holds.
+    if (l->outstanding) {
+        l->stats.stalls++;
+        send_msg(l, MSG_SYNC, 0, ++l->sync_seq);
+
+        //time stands still here, a partner clocking at the same time gets FF.
+        while ((l->outstanding || l->synced_seq != l->sync_seq) && !l->rollback && l->connected) {
+            if (l->incoming) {
+                take_incoming(l);
+            }
+
+            check_sync(l, true);
+            receive(l, true);
+        }
+    }
+
+    l->completed = true;
+    l->out = out;
+    l->prediction = l->remote_waiting ? l->remote_sb : 0xFF;
+    l->stats.transfers++;
+
+    return l->prediction;
+}
+
+static void rollback(link_cable *l) {
+    emu_context *emu = emu_get_context();
+
+    state_load(l->spec_state, l->spec_size);
+    serial_get_context()->sb = l->rollback_value;
+
+    for (int i=0; i<l->replay_count; i++) {
+        serial_external(l->replay[i]);
+    }
+
+    l->stats.rollbacks++;
+    l->stats.rollback_ticks += emu->ticks - l->spec_ticks;
+
+    //the ticks keep counting, the link time goes back with the state.
+    l->start += emu->ticks - l->spec_ticks;
+
+    //a transfer that finished after the saved state never happened.
+    if (l->completed) {
+        l->completed = false;
+        l->stats.transfers--;
+    }
+
+    l->seq = l->spec_seq + 1;
+    l->rollback = false;
+    l->outstanding = false;
+    l->replay_count = 0;
+}
+
+static void speculate(link_cable *l) {
+    emu_context *emu = emu_get_context();
+    u32 size = state_size();
+
+    if (size > l->spec_capacity) {
+        l->spec_state = realloc(l->spec_state, size);
+        l->spec_capacity = size;
+    }
+
+    l->spec_size = state_save(l->spec_state, size);
+    l->spec_seq = l->seq;
+    l->spec_prediction = l->prediction;
+    l->spec_ticks = emu->ticks;
+    l->outstanding = true;
+    l->stats.speculations++;
+}
+
+bool link_poll(link_cable *l) {
+    emu_context *emu = emu_get_context();
+
+    if (l->rollback) {
+        rollback(l);
+    } else if (l->completed) {
+        l->completed = false;
+        send_msg(l, MSG_BYTE, l->out, l->seq);
+
+        if (l->connected) {
+            speculate(l);
+        }
+
+        l->seq++;
+    }
+
+    //what the partner gets if it clocks a transfer now.
+    bool waiting = serial_waiting();
+    u8 sb = serial_get_context()->sb;
+
+    if (waiting != l->announced_waiting || (waiting && sb != l->announced_sb)) {
+        send_msg(l, waiting ? MSG_READY : MSG_IDLE, sb, 0);
+        l->announced_waiting = waiting;
+        l->announced_sb = sb;
+    }
+
+    if (emu->ticks - l->last_poll >= LINK_POLL_TICKS) {
+        l->last_poll = emu->ticks;
+
+        while (receive(l, false));
+
+        if (l->rollback) {
+            rollback(l);
+        }
+    }
+
+    if (l->incoming && link_time(l) >= l->incoming_msg.time) {
+        take_incoming(l);
+    }
+
+    check_sync(l, false);
+
+    return l->connected;
+}
+
+static bool socket_address(const char *path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        printf("Link socket path is too long: %s\n", path);
+        return false;
+    }
+
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+link_cable *link_listen(const char *path) {
+    struct sockaddr_un addr;
+
+    if (!socket_address(path, &addr)) {
+        return NULL;
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+
+    if (server < 0 || bind(server, (struct sockaddr *)&addr, sizeof(addr)) || listen(server, 1)) {
+        printf("Failed to listen on: %s\n", path);
+
+        if (server >= 0) {
+            close(server);
+        }
+
+        return NULL;
+    }
+
+    printf("Waiting for the other side of the link cable on: %s\n", path);
+
+    int fd = accept(server, NULL, NULL);
+    close(server);
+    unlink(path);
+
+    if (fd < 0) {
+        printf("Failed to accept the link cable on: %s\n", path);
+        return NULL;
+    }
+
+    return link_socket(fd);
+}
+
+link_cable *link_connect(const char *path) {
+    struct sockaddr_un addr;
+
+    if (!socket_address(path, &addr)) {
+        return NULL;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        printf("Failed to connect the link cable to: %s\n", path);
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return NULL;
+    }
+
+    return link_socket(fd);
+}
+
+link_cable *link_socket(int fd) {
+    link_cable *l = calloc(1, sizeof(link_cable));
+
+    l->fd = fd;
+    l->connected = true;
+    l->start = emu_get_context()->ticks;
+    l->last_poll = l->start;
+
+    serial_set_sink(socket_sink, l);
+
+    return l;
+}
+
+void link_get_stats(link_cable *l, link_stats *stats) {
+    *stats = l->stats;
+
+    if (l->local) {
+        stats->transfers = l->ports[0].transfers + l->ports[1].transfers;
+    }
+}
+
+void link_free(link_cable *l) {
+    if (!l) {
+        return;
+    }
+
+    if (l->local) {
+        if (l->threads == 2) {
+            l->exit = true;
+            pthread_barrier_wait(&l->barrier);
+            pthread_join(l->worker, NULL);
+            pthread_barrier_destroy(&l->barrier);
+        }
+
+        for (int i=1; i>=0; i--) {
+            machine_bind(l->ports[i].m);
+            serial_set_sink(NULL, NULL);
+        }
+    } else {
+        serial_set_sink(NULL, NULL);
+        close(l->fd);
+        free(l->spec_state);
+    }
+
+    free(l);
+}
@@ -0,0 +1,113 @@
+#include <machine.h>
+#include <string.h>
+
+machine *machine_new() {
+    machine *m = calloc(1, sizeof(machine));
+
+    if (m) {
+        m->movie.first_desync = -1;
+    }
+
+    return m;
+}
+
+machine *machine_fork(machine *parent) {
+    machine *m = malloc(sizeof(machine));
+
+    if (!m) {
+        return NULL;
+    }
+
+    *m = *parent;
+
+    if (m->cart.rom) {
+        rom_retain(m->cart.rom);
+    }
+
+    page_share(m->cart.ram_pages, CART_RAM_BANKS * CART_RAM_BANK_PAGES);
+    page_share(m->ram.wram, PAGE_COUNT(WRAM_CGB_SIZE));
+
+    if (parent->cart.ram_bank) {
+        m->cart.ram_bank = m->cart.ram_pages + (parent->cart.ram_bank - parent->cart.ram_pages);
+    }
+
+    if (parent->cart.ram_map) {
+        m->cart.ram_map = m->cart.ram_pages + (parent->cart.ram_map - parent->cart.ram_pages);
+    }
+
+    m->cart.ext_ram = NULL;
+
+    //the fork renders once it is asked to.
+    m->ppu.video_buffer = NULL;
+    ppu_copy_context(&m->ppu, &parent->ppu);
+    m->ppu.frame_render = false;
+    m->ppu.next_frame_render = false;
+    m->ppu.deferred = false;
+
+    //nobody hears the fork.
+    m->sound.sink = NULL;
+    m->sound.sink_user = NULL;
+    m->sound.samples = NULL;
+    m->sound.pos = 0;
+    m->sound.blip[0].deltas = NULL;
+    m->sound.blip[1].deltas = NULL;
+
+    //nothing is plugged into the fork's serial port.
+    m->serial.sink = NULL;
+    m->serial.sink_user = NULL;
+
+    memset(&m->movie, 0, sizeof(m->movie));
+    m->movie.first_desync = -1;
+
+    //only the parent writes the .battery file.
+    memset(&m->battery, 0, sizeof(m->battery));
+
+    return m;
+}
+
+void machine_bind(machine *m) {
+    cart_set_context(&m->cart);
+    cpu_set_context(&m->cpu);
+    timer_set_context(&m->timer);
+    dma_set_context(&m->dma);
+    ram_set_context(&m->ram);
+    io_set_context(&m->io);
+    serial_set_context(&m->serial);
+    gamepad_set_context(&m->gamepad);
+    sound_set_context(&m->sound);
+    ppu_set_context(&m->ppu);
+    lcd_set_context(&m->lcd);
+    emu_set_context(&m->emu);
+    movie_set_context(&m->movie);
+    battery_set_context(&m->battery);
+}
+
+void machine_free(machine *m) {
+    if (!m) {
+        return;
+    }
+
+    //the rest of the save is written from the machine's own cart.
+    if (m->battery.active) {
+        machine_bind(m);
+        battery_stop();
+    }
+
+    rom_release(m->cart.rom);
+
+    page_release(m->cart.ram_pages, CART_RAM_BANKS * CART_RAM_BANK_PAGES);
+    page_release(m->ram.wram, PAGE_COUNT(WRAM_CGB_SIZE));
+    page_release(m->ppu.vram, PAGE_COUNT(VRAM_CGB_SIZE));
+
+    free(m->cart.ext_ram);
+    free(m->ppu.video_buffer);
+    free(m->sound.samples);
+    blip_free(&m->sound.blip[0]);
+    blip_free(&m->sound.blip[1]);
+
+    free(m->movie.start_state);
+    free(m->movie.buttons);
+    free(m->movie.hashes);
+
+    free(m);
+}
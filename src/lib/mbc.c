@@ -0,0 +1,349 @@
+#include <mbc.h>
+#include <cart.h>
+#include <emu.h>
+#include <string.h>
+#include <time.h>
+
+#define RTC_HZ 4194304ULL
+#define RTC_DAY (86400ULL * RTC_HZ)
+#define RTC_DAYS 512
+
+static void rom_only_write(u16 address, u8 value) {
+}
+
+static u8 no_ram_read(u16 address) {
+    return 0xFF;
+}
+
+static void no_ram_write(u16 address, u8 value) {
+}
+
+//the rom is mapped, banks past its end wrap around instead.
+static const u8 *rom_bank(cart_context *cart, u16 bank) {
+    return cart->rom_data + 0x4000 * (bank % cart->rom_banks);
+}
+
+static void rom_only_map() {
+    cart_context *cart = cart_get_context();
+
+    cart->rom_bank_0 = cart->rom_data;
+    cart->rom_bank_x = rom_bank(cart, 1);
+}
+
+static void mbc1_map() {
+    cart_context *cart = cart_get_context();
+    u16 bank = cart->rom_bank_value ? cart->rom_bank_value : 1;
+    u16 upper = cart->ram_bank_value << 5;
+
+    //carts of 1MB and more use the ram bank register for the upper rom bits.
+    cart->rom_bank_0 = cart->banking_mode ? rom_bank(cart, upper) : cart->rom_data;
+    cart->rom_bank_x = rom_bank(cart, upper | bank);
+}
+
+static void mbc1_write(u16 address, u8 value) {
+    cart_context *cart = cart_get_context();
+
+    switch (address >> 13) {
+        case 0:
+            cart->ram_enabled = ((value & 0xF) == 0xA);
+            break;
+
+        case 1:
+            //rom bank number
+            if (value == 0) {
+                value = 1;
+            }
+
+            cart->rom_bank_value = value & 0b11111;
+            break;
+
+        case 2:
+            //ram bank number
+            cart->ram_bank_value = value & 0b11;
+
+            if (cart->ram_banking) {
+                cart->ram_bank = cart_ram_bank(cart->ram_bank_value);
+            }
+            break;
+
+        case 3:
+            //banking mode select
+            cart->banking_mode = value & 1;
+            cart->ram_banking = cart->banking_mode;
+
+            if (cart->ram_banking) {
+                cart->ram_bank = cart_ram_bank(cart->ram_bank_value);
+            }
+            break;
+    }
+
+    mbc1_map();
+}
+
+static u64 rtc_now(cart_rtc *rtc) {
+    u64 ticks = emu_get_context()->ticks;
+
+    //an anchor past the tick counter was set before the counter was reset.
+    if (rtc->halted || ticks < rtc->ticks) {
+        return rtc->time;
+    }
+
+    return rtc->time + (ticks - rtc->ticks);
+}
+
+static void rtc_set(cart_rtc *rtc, u64 time) {
+    rtc->time = time;
+    rtc->ticks = emu_get_context()->ticks;
+}
+
+//the clock with the day counter overflow applied.
+static u64 rtc_current(cart_rtc *rtc) {
+    u64 time = rtc_now(rtc);
+
+    if (time >= RTC_DAYS * RTC_DAY) {
+        rtc->carry = true;
+        time %= RTC_DAYS * RTC_DAY;
+        rtc_set(rtc, time);
+    }
+
+    return time;
+}
+
+static void rtc_split(cart_rtc *rtc, u64 time, u8 *regs) {
+    u64 seconds = time / RTC_HZ;
+    u64 days = seconds / 86400;
+
+    regs[0] = seconds % 60;
+    regs[1] = (seconds / 60) % 60;
+    regs[2] = (seconds / 3600) % 24;
+    regs[3] = days & 0xFF;
+    regs[4] = ((days >> 8) & 1) | (rtc->halted << 6) | (rtc->carry << 7);
+}
+
+static u64 rtc_join(const u8 *regs) {
+    u64 days = regs[3] | ((regs[4] & 1) << 8);
+
+    return (((days * 24 + regs[2]) * 60 + regs[1]) * 60 + regs[0]) * RTC_HZ;
+}
+
+static void rtc_write(cart_rtc *rtc, int reg, u8 value) {
+    static const u8 MASKS[5] = { 0x3F, 0x3F, 0x1F, 0xFF, 0xC1 };
+
+    u64 time = rtc_current(rtc);
+    u8 regs[5];
+    rtc_split(rtc, time, regs);
+
+    //writing the seconds resets the divider.
+    u64 divider = reg == 0 ? 0 : time % RTC_HZ;
+    regs[reg] = value & MASKS[reg];
+    rtc->regs[reg] = regs[reg];
+
+    if (reg == 4) {
+        rtc->halted = value & 0x40;
+        rtc->carry = value & 0x80;
+    }
+
+    rtc_set(rtc, rtc_join(regs) + divider);
+    cart_get_context()->rtc_dirty = true;
+}
+
+static void mbc3_map() {
+    cart_context *cart = cart_get_context();
+
+    cart->rom_bank_0 = cart->rom_data;
+    cart->rom_bank_x = rom_bank(cart, cart->rom_bank_value ? cart->rom_bank_value : 1);
+}
+
+static void mbc3_write(u16 address, u8 value) {
+    cart_context *cart = cart_get_context();
+
+    switch (address >> 13) {
+        case 0:
+            cart->ram_enabled = ((value & 0xF) == 0xA);
+            break;
+
+        case 1:
+            cart->rom_bank_value = value & 0x7F;
+            mbc3_map();
+            break;
+
+        case 2:
+            //ram bank 0-3 or rtc register 8-C, which goes through mbc3_ram_read.
+            cart->ram_bank_value = value;
+            cart->ram_bank = value < 4 ? cart_ram_bank(value) : NULL;
+            break;
+
+        case 3:
+            if (cart->rtc.latch == 0 && value == 1 && cart->has_rtc) {
+                rtc_split(&cart->rtc, rtc_current(&cart->rtc), cart->rtc.regs);
+            }
+
+            cart->rtc.latch = value;
+            break;
+    }
+}
+
+static u8 mbc3_ram_read(u16 address) {
+    cart_context *cart = cart_get_context();
+
+    if (!cart->ram_enabled || !cart->has_rtc || !BETWEEN(cart->ram_bank_value, 0x08, 0x0C)) {
+        return 0xFF;
+    }
+
+    return cart->rtc.regs[cart->ram_bank_value - 0x08];
+}
+
+static void mbc3_ram_write(u16 address, u8 value) {
+    cart_context *cart = cart_get_context();
+
+    if (!cart->ram_enabled || !cart->has_rtc || !BETWEEN(cart->ram_bank_value, 0x08, 0x0C)) {
+        return;
+    }
+
+    rtc_write(&cart->rtc, cart->ram_bank_value - 0x08, value);
+}
+
+static void mbc5_map() {
+    cart_context *cart = cart_get_context();
+
+    //bank 0 can be mapped at 4000-7FFF too.
+    cart->rom_bank_0 = cart->rom_data;
+    cart->rom_bank_x = rom_bank(cart, cart->rom_bank_value);
+}
+
+static void mbc5_write_masked(u16 address, u8 value, u8 ram_bank_mask) {
+    cart_context *cart = cart_get_context();
+
+    switch (address >> 12) {
+        case 0: case 1:
+            cart->ram_enabled = ((value & 0xF) == 0xA);
+            break;
+
+        case 2:
+            cart->rom_bank_value = (cart->rom_bank_value & 0x100) | value;
+            mbc5_map();
+            break;
+
+        case 3:
+            cart->rom_bank_value = (cart->rom_bank_value & 0xFF) | ((value & 1) << 8);
+            mbc5_map();
+            break;
+
+        case 4: case 5:
+            cart->ram_bank_value = value & ram_bank_mask;
+
+            //16 banks at most, fewer wrap around.
+            if (cart->ram_bank_count) {
+                cart->ram_bank = cart_ram_bank(cart->ram_bank_value % cart->ram_bank_count);
+            }
+            break;
+    }
+}
+
+static void mbc5_write(u16 address, u8 value) {
+    mbc5_write_masked(address, value, 0x0F);
+}
+
+//bit 3 of the ram bank register drives the motor.
+static void mbc5_rumble_write(u16 address, u8 value) {
+    mbc5_write_masked(address, value, 0x07);
+}
+
+static const cart_mapper ROM_ONLY = { "ROM", rom_only_map, rom_only_write, no_ram_read, no_ram_write, 8, true };
+static const cart_mapper MBC1 = { "MBC1", mbc1_map, mbc1_write, no_ram_read, no_ram_write, 8, false };
+static const cart_mapper MBC3 = { "MBC3", mbc3_map, mbc3_write, mbc3_ram_read, mbc3_ram_write, 8, false };
+static const cart_mapper MBC5 = { "MBC5", mbc5_map, mbc5_write, no_ram_read, no_ram_write, 9, false };
+static const cart_mapper MBC5_RUMBLE = { "MBC5", mbc5_map, mbc5_rumble_write, no_ram_read, no_ram_write, 9, false };
+
+static const cart_type_info CART_TYPES[0x100] = {
+    [0x00] = { &ROM_ONLY },
+    [0x01] = { &MBC1 },
+    [0x02] = { &MBC1 },
+    [0x03] = { &MBC1, true },
+    [0x08] = { &ROM_ONLY },
+    [0x09] = { &ROM_ONLY, true },
+    [0x0F] = { &MBC3, true, true },
+    [0x10] = { &MBC3, true, true },
+    [0x11] = { &MBC3 },
+    [0x12] = { &MBC3 },
+    [0x13] = { &MBC3, true },
+    [0x19] = { &MBC5 },
+    [0x1A] = { &MBC5 },
+    [0x1B] = { &MBC5, true },
+    [0x1C] = { &MBC5_RUMBLE },
+    [0x1D] = { &MBC5_RUMBLE },
+    [0x1E] = { &MBC5_RUMBLE, true },
+};
+
+const cart_type_info *mbc_type_info(u8 type) {
+    return CART_TYPES[type].mapper ? &CART_TYPES[type] : &CART_TYPES[0];
+}
+
+u64 mbc_rtc_get_clock() {
+    return rtc_now(&cart_get_context()->rtc);
+}
+
+void mbc_rtc_set_clock(u64 clock) {
+    rtc_set(&cart_get_context()->rtc, clock);
+}
+
+static void put_u32(u8 *p, u32 value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+}
+
+static u32 get_u32(const u8 *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+void mbc_rtc_save(u8 *trailer) {
+    cart_rtc *rtc = &cart_get_context()->rtc;
+    u8 regs[5];
+    rtc_split(rtc, rtc_current(rtc), regs);
+
+    for (int i=0; i<5; i++) {
+        put_u32(trailer + i * 4, regs[i]);
+        put_u32(trailer + 20 + i * 4, rtc->regs[i]);
+    }
+
+    u64 now = time(NULL);
+    put_u32(trailer + 40, now & 0xFFFFFFFF);
+    put_u32(trailer + 44, now >> 32);
+}
+
+bool mbc_rtc_load(const u8 *trailer, u32 size) {
+    cart_rtc *rtc = &cart_get_context()->rtc;
+
+    //some emulators write a 32 bit timestamp.
+    if (size < RTC_TRAILER_SIZE - 4) {
+        return false;
+    }
+
+    u8 regs[5];
+
+    for (int i=0; i<5; i++) {
+        regs[i] = get_u32(trailer + i * 4);
+        rtc->regs[i] = get_u32(trailer + 20 + i * 4);
+    }
+
+    u64 saved = get_u32(trailer + 40);
+
+    if (size >= RTC_TRAILER_SIZE) {
+        saved |= (u64)get_u32(trailer + 44) << 32;
+    }
+
+    rtc->halted = regs[4] & 0x40;
+    rtc->carry = regs[4] & 0x80;
+
+    u64 clock = rtc_join(regs);
+    u64 now = time(NULL);
+
+    if (!rtc->halted && now > saved) {
+        clock += (now - saved) * RTC_HZ;
+    }
+
+    rtc_set(rtc, clock);
+    return true;
+}
@@ -0,0 +1,302 @@
+#include <movie.h>
+#include <state.h>
+#include <cart.h>
+#include <gamepad.h>
+#include <string.h>
+
+static movie_context main_ctx;
+static _Thread_local movie_context *ctx = &main_ctx;
+
+movie_context *movie_get_context() {
+    return ctx;
+}
+
+void movie_set_context(movie_context *context) {
+    ctx = context;
+}
+
+static void write_u32(FILE *fp, u32 value) {
+    u8 b[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+    fwrite(b, 4, 1, fp);
+}
+
+static void write_u64(FILE *fp, u64 value) {
+    write_u32(fp, value & 0xFFFFFFFF);
+    write_u32(fp, value >> 32);
+}
+
+static u32 read_u32(FILE *fp) {
+    u8 b[4] = {0};
+
+    if (fread(b, 4, 1, fp) != 1) {
+        return 0;
+    }
+
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((u32)b[3] << 24);
+}
+
+static u64 read_u64(FILE *fp) {
+    u64 lo = read_u32(fp);
+    return lo | ((u64)read_u32(fp) << 32);
+}
+
+static void reset() {
+    free(ctx->start_state);
+    free(ctx->buttons);
+    free(ctx->hashes);
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->first_desync = -1;
+}
+
+static void record_buttons() {
+    gamepad_context *gamepad = gamepad_get_context();
+
+    if (ctx->frames == ctx->frames_capacity) {
+        ctx->frames_capacity = ctx->frames_capacity ? ctx->frames_capacity * 2 : 3600;
+        ctx->buttons = realloc(ctx->buttons, ctx->frames_capacity);
+    }
+
+    //the frontend's input becomes the game's input for the whole frame.
+    gamepad->controller = gamepad->input;
+    ctx->buttons[ctx->frames++] = gamepad_pack(&gamepad->controller);
+}
+
+static void record_hash(u64 hash) {
+    if (ctx->hash_count == ctx->hash_capacity) {
+        ctx->hash_capacity = ctx->hash_capacity ? ctx->hash_capacity * 2 : 64;
+        ctx->hashes = realloc(ctx->hashes, ctx->hash_capacity * sizeof(u64));
+    }
+
+    ctx->hashes[ctx->hash_count++] = hash;
+}
+
+u64 movie_rom_hash() {
+    return rom_hash(cart_get_context()->rom);
+}
+
+u64 movie_state_hash() {
+    return state_hash();
+}
+
+bool movie_record_start(u32 hash_interval) {
+    reset();
+
+    ctx->rom_hash = movie_rom_hash();
+    ctx->hash_interval = hash_interval ? hash_interval : 60;
+
+    ctx->state_size = state_size();
+    ctx->start_state = malloc(ctx->state_size);
+    state_save(ctx->start_state, ctx->state_size);
+
+    gamepad_set_latched(true);
+    ctx->mode = MOVIE_RECORD;
+
+    record_buttons();
+
+    return true;
+}
+
+bool movie_save(const char *filename) {
+    if (!ctx->start_state) {
+        return false;
+    }
+
+    FILE *fp = fopen(filename, "wb");
+
+    if (!fp) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", filename);
+        return false;
+    }
+
+    fwrite("GBMV", 4, 1, fp);
+    write_u32(fp, MOVIE_VERSION);
+    write_u64(fp, ctx->rom_hash);
+    write_u32(fp, ctx->frames);
+    write_u32(fp, ctx->hash_interval);
+    write_u32(fp, ctx->hash_count);
+    write_u32(fp, ctx->state_size);
+    fwrite(ctx->start_state, ctx->state_size, 1, fp);
+    fwrite(ctx->buttons, ctx->frames, 1, fp);
+
+    for (u32 i=0; i<ctx->hash_count; i++) {
+        write_u64(fp, ctx->hashes[i]);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+bool movie_play_start(const char *filename) {
+    reset();
+
+    FILE *fp = fopen(filename, "rb");
+
+    if (!fp) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", filename);
+        return false;
+    }
+
+    char magic[4] = {0};
+    fread(magic, 4, 1, fp);
+    u32 version = read_u32(fp);
+
+    if (memcmp(magic, "GBMV", 4) || version != MOVIE_VERSION) {
+        fprintf(stderr, "Not a movie file: %s\n", filename);
+        fclose(fp);
+        return false;
+    }
+
+    ctx->rom_hash = read_u64(fp);
+    ctx->frames = read_u32(fp);
+    ctx->hash_interval = read_u32(fp);
+    ctx->hash_count = read_u32(fp);
+    ctx->state_size = read_u32(fp);
+
+    if (ctx->rom_hash != movie_rom_hash()) {
+        fprintf(stderr, "Movie was recorded with another rom\n");
+        fclose(fp);
+        reset();
+        return false;
+    }
+
+    if (!ctx->hash_interval) {
+        ctx->hash_interval = 60;
+    }
+
+    if (ctx->hash_count > ctx->frames / ctx->hash_interval) {
+        ctx->hash_count = ctx->frames / ctx->hash_interval;
+    }
+
+    //a state of this rom always has the same size.
+    if (ctx->state_size != state_size()) {
+        fprintf(stderr, "Movie start state doesn't fit the rom: %s\n", filename);
+        fclose(fp);
+        reset();
+        return false;
+    }
+
+    //the sizes come from the file, everything they cover has to be in it.
+    long pos = ftell(fp);
+    fseek(fp, 0, SEEK_END);
+    long end = ftell(fp);
+    fseek(fp, pos, SEEK_SET);
+
+    if (pos < 0 || end < pos ||
+        (u64)(end - pos) < (u64)ctx->state_size + ctx->frames + (u64)ctx->hash_count * 8) {
+        fprintf(stderr, "Movie is truncated: %s\n", filename);
+        fclose(fp);
+        reset();
+        return false;
+    }
+
+    ctx->start_state = malloc(ctx->state_size);
+    ctx->buttons = malloc((size_t)ctx->frames + 1);
+    ctx->hashes = malloc(((size_t)ctx->hash_count + 1) * sizeof(u64));
+
+    if (!ctx->start_state || !ctx->buttons || !ctx->hashes) {
+        fprintf(stderr, "Couldn't allocate the movie: %s\n", filename);
+        fclose(fp);
+        reset();
+        return false;
+    }
+
+    bool ok = fread(ctx->start_state, ctx->state_size, 1, fp) == 1 &&
+        (!ctx->frames || fread(ctx->buttons, ctx->frames, 1, fp) == 1);
+
+    for (u32 i=0; i<ctx->hash_count; i++) {
+        ctx->hashes[i] = read_u64(fp);
+    }
+
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "Movie is truncated: %s\n", filename);
+        reset();
+        return false;
+    }
+
+    if (!state_load(ctx->start_state, ctx->state_size)) {
+        reset();
+        return false;
+    }
+
+    gamepad_set_latched(true);
+    ctx->mode = MOVIE_PLAY;
+    ctx->finished = !ctx->frames;
+
+    if (ctx->frames) {
+        gamepad_unpack(ctx->buttons[0], &gamepad_get_context()->controller);
+    }
+
+    return true;
+}
+
+void movie_frame() {
+    if (ctx->mode == MOVIE_NONE || ctx->finished) {
+        return;
+    }
+
+    ctx->frame++;
+
+    if ((ctx->frame % ctx->hash_interval) == 0) {
+        u64 hash = state_hash();
+        u32 index = ctx->frame / ctx->hash_interval - 1;
+
+        if (ctx->mode == MOVIE_RECORD) {
+            record_hash(hash);
+        } else if (index < ctx->hash_count && hash != ctx->hashes[index]) {
+            if (ctx->first_desync < 0) {
+                ctx->first_desync = ctx->frame;
+            }
+
+            ctx->desyncs++;
+        }
+    }
+
+    if (ctx->mode == MOVIE_RECORD) {
+        record_buttons();
+        return;
+    }
+
+    if (ctx->frame >= ctx->frames) {
+        ctx->finished = true;
+        return;
+    }
+
+    gamepad_unpack(ctx->buttons[ctx->frame], &gamepad_get_context()->controller);
+}
+
+void movie_stop() {
+    if (ctx->mode == MOVIE_RECORD) {
+        //the input of the unfinished frame is dropped.
+        ctx->frames = ctx->frame;
+    }
+
+    gamepad_set_latched(false);
+    ctx->mode = MOVIE_NONE;
+}
+
+movie_mode movie_get_mode() {
+    return ctx->mode;
+}
+
+bool movie_finished() {
+    return ctx->finished;
+}
+
+u32 movie_get_frame() {
+    return ctx->frame;
+}
+
+u32 movie_get_frames() {
+    return ctx->frames;
+}
+
+u32 movie_get_desyncs() {
+    return ctx->desyncs;
+}
+
+int movie_first_desync() {
+    return ctx->first_desync;
+}
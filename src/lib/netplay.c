@@ -0,0 +1,465 @@
+#include <netplay.h>
+#include <link.h>
+#include <state.h>
+#include <gamepad.h>
+#include <ppu.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//inputs kept per side, by frame modulo. Covers the window behind the
+//current frame and the inputs the remote can be ahead.
+#define NETPLAY_HISTORY 256
+
+//the remote is at most two windows behind on our inputs.
+#define NETPLAY_PACKET_INPUTS (NETPLAY_MAX_ROLLBACK * 2)
+
+//datagrams held back for the injected latency, more are dropped.
+#define NETPLAY_QUEUE 256
+
+//while nothing new is sent the inputs are sent again this often.
+#define NETPLAY_RESEND_MS 4
+
+typedef struct {
+    u32 frame; //of the first input.
+    u32 ack; //the sender has the receiver's inputs of all frames before this.
+    u16 count;
+    u8 buttons[NETPLAY_PACKET_INPUTS];
+} netplay_packet;
+
+//a snapshot of one machine, size is 0 if it couldn't be saved.
+typedef struct {
+    u8 *data;
+    u32 size;
+    u32 capacity;
+} netplay_state;
+
+typedef struct {
+    double due;
+    u32 size;
+    netplay_packet packet;
+} netplay_delayed;
+
+struct netplay {
+    netplay_config config;
+    machine *m[2];
+    link_cable *cable;
+
+    u32 frame; //the next frame to run.
+    u32 confirmed; //frames before this ran with the remote's input.
+    u32 received; //the remote's inputs of the frames before this are known.
+    u32 inputs; //our inputs of the frames before this are known.
+    u32 acked; //the remote has our inputs of the frames before this.
+
+    u8 local[NETPLAY_HISTORY];
+    u8 remote[NETPLAY_HISTORY];
+    u8 used[NETPLAY_HISTORY]; //the remote input the frame ran with.
+
+    //both machines at the start of the last max_rollback + 1 frames, by frame modulo.
+    netplay_state states[NETPLAY_MAX_ROLLBACK + 1][2];
+
+    netplay_delayed *queue;
+    u32 queue_first;
+    u32 queue_count;
+    double last_send;
+    u32 sent_inputs;
+    u32 rng;
+
+    netplay_stats stats;
+};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static netplay_state *slot(netplay *np, u32 frame) {
+    return np->states[frame % (np->config.max_rollback + 1)];
+}
+
+//the buffer grows when the state did, the size is only queried then.
+static void save_state(netplay_state *state) {
+    state->size = state_save(state->data, state->capacity);
+
+    if (!state->size) {
+        u32 size = state_size();
+        u8 *data = realloc(state->data, size);
+
+        if (!data) {
+            fprintf(stderr, "Couldn't allocate a netplay snapshot\n");
+            return;
+        }
+
+        state->data = data;
+        state->capacity = size;
+        state->size = state_save(data, size);
+    }
+}
+
+static void save_states(netplay *np, u32 frame) {
+    netplay_state *states = slot(np, frame);
+
+    for (int i=0; i<2; i++) {
+        machine_bind(np->m[i]);
+        save_state(&states[i]);
+    }
+}
+
+//a machine whose snapshot is missing keeps running from where it is.
+static void load_states(netplay *np, u32 frame) {
+    netplay_state *states = slot(np, frame);
+
+    for (int i=0; i<2; i++) {
+        machine_bind(np->m[i]);
+
+        if (states[i].size) {
+            state_load(states[i].data, states[i].size);
+        }
+    }
+}
+
+//the remote keeps pressing what it pressed last.
+static u8 remote_input(netplay *np, u32 frame) {
+    if (frame < np->received) {
+        return np->remote[frame % NETPLAY_HISTORY];
+    }
+
+    return np->received ? np->remote[(np->received - 1) % NETPLAY_HISTORY] : 0;
+}
+
+static void run_frame(netplay *np, u32 frame, bool render) {
+    u8 buttons[2];
+    int player = np->config.player;
+
+    buttons[player] = np->local[frame % NETPLAY_HISTORY];
+    buttons[!player] = remote_input(np, frame);
+    np->used[frame % NETPLAY_HISTORY] = buttons[!player];
+
+    save_states(np, frame);
+
+    for (int i=0; i<2; i++) {
+        machine_bind(np->m[i]);
+        gamepad_unpack(buttons[i], &gamepad_get_context()->controller);
+        ppu_set_frame_render(render && i == player);
+    }
+
+    //the quanta start at every frame, a frame run again runs the same.
+    link_restart(np->cable);
+    link_run(np->cable, LINES_PER_FRAME * TICKS_PER_LINE);
+}
+
+//the last frame is rendered, the picture finishing in the next one starts there.
+static void resimulate(netplay *np, u32 from) {
+    load_states(np, from);
+
+    for (u32 frame=from; frame<np->frame; frame++) {
+        run_frame(np, frame, frame + 1 == np->frame);
+    }
+}
+
+static void receive(netplay *np) {
+    netplay_packet packet;
+    ssize_t size;
+
+    while ((size = recv(np->config.fd, &packet, sizeof(packet), MSG_DONTWAIT)) > 0) {
+        size_t n = size;
+
+        if (n < offsetof(netplay_packet, buttons) || packet.count > NETPLAY_PACKET_INPUTS ||
+            n < offsetof(netplay_packet, buttons) + packet.count) {
+            continue;
+        }
+
+        np->stats.received++;
+
+        if (packet.ack > np->acked && packet.ack <= np->inputs) {
+            np->acked = packet.ack;
+        }
+
+        //inputs are taken in order, the ones already known are repeats.
+        for (u32 i=0; i<packet.count; i++) {
+            if (packet.frame + i == np->received) {
+                np->remote[np->received % NETPLAY_HISTORY] = packet.buttons[i];
+                np->received++;
+            }
+        }
+    }
+}
+
+//frames that ran with a wrong prediction are run again.
+static void confirm(netplay *np) {
+    u32 known = np->received < np->frame ? np->received : np->frame;
+    u32 wrong = known;
+
+    for (u32 frame=np->confirmed; frame<known; frame++) {
+        if (np->remote[frame % NETPLAY_HISTORY] != np->used[frame % NETPLAY_HISTORY]) {
+            wrong = frame;
+            break;
+        }
+    }
+
+    np->confirmed = known;
+
+    if (wrong == known) {
+        return;
+    }
+
+    double start = now();
+    resimulate(np, wrong);
+    double ms = (now() - start) * 1000;
+
+    np->stats.rollbacks++;
+    np->stats.rollback_frames += np->frame - wrong;
+    np->stats.rollback_ms += ms;
+
+    if (np->frame - wrong > np->stats.max_depth) {
+        np->stats.max_depth = np->frame - wrong;
+    }
+
+    if (ms > np->stats.max_rollback_ms) {
+        np->stats.max_rollback_ms = ms;
+    }
+}
+
+static bool drop(netplay *np) {
+    np->rng ^= np->rng << 13;
+    np->rng ^= np->rng >> 17;
+    np->rng ^= np->rng << 5;
+
+    return np->rng / 4294967296.0 < np->config.loss;
+}
+
+static void flush_queue(netplay *np) {
+    double time = now();
+
+    while (np->queue_count && np->queue[np->queue_first].due <= time) {
+        netplay_delayed *delayed = &np->queue[np->queue_first];
+
+        send(np->config.fd, &delayed->packet, delayed->size, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        np->queue_first = (np->queue_first + 1) % NETPLAY_QUEUE;
+        np->queue_count--;
+    }
+}
+
+//all inputs the remote doesn't have, when there are new ones or it's time to repeat them.
+static void send_inputs(netplay *np) {
+    double time = now();
+
+    if (np->inputs == np->sent_inputs && time - np->last_send < NETPLAY_RESEND_MS / 1000.0) {
+        return;
+    }
+
+    np->last_send = time;
+    np->sent_inputs = np->inputs;
+    np->stats.sent++;
+
+    if (drop(np) || np->queue_count == NETPLAY_QUEUE) {
+        np->stats.dropped++;
+        return;
+    }
+
+    netplay_delayed *delayed = &np->queue[(np->queue_first + np->queue_count++) % NETPLAY_QUEUE];
+    netplay_packet *packet = &delayed->packet;
+
+    packet->frame = np->acked;
+
+    if (np->inputs - packet->frame > NETPLAY_PACKET_INPUTS) {
+        packet->frame = np->inputs - NETPLAY_PACKET_INPUTS;
+    }
+
+    packet->ack = np->received;
+    packet->count = np->inputs - packet->frame;
+
+    for (u32 i=0; i<packet->count; i++) {
+        packet->buttons[i] = np->local[(packet->frame + i) % NETPLAY_HISTORY];
+    }
+
+    delayed->due = time + np->config.latency_ms / 1000.0;
+    delayed->size = offsetof(netplay_packet, buttons) + packet->count;
+}
+
+netplay *netplay_new(machine *a, machine *b, const netplay_config *config) {
+    netplay *np = calloc(1, sizeof(netplay));
+
+    np->config = *config;
+    np->config.player = config->player ? 1 : 0;
+
+    if (!np->config.max_rollback) {
+        np->config.max_rollback = NETPLAY_ROLLBACK;
+    } else if (np->config.max_rollback > NETPLAY_MAX_ROLLBACK) {
+        np->config.max_rollback = NETPLAY_MAX_ROLLBACK;
+    }
+
+    np->m[0] = a;
+    np->m[1] = b;
+
+    for (int i=0; i<2; i++) {
+        machine_bind(np->m[i]);
+        gamepad_set_latched(true);
+
+        u32 size = state_size();
+
+        for (u32 j=0; j<=np->config.max_rollback; j++) {
+            netplay_state *state = &np->states[j][i];
+
+            state->data = malloc(size);
+            state->capacity = state->data ? size : 0;
+        }
+    }
+    np->queue = calloc(NETPLAY_QUEUE, sizeof(netplay_delayed));
+    np->rng = config->seed ? config->seed : 1;
+
+    //one thread, the rollbacks are short and the other thread's barriers would cost more.
+    np->cable = link_local(a, b, 1);
+
+    machine_bind(np->m[np->config.player]);
+    return np;
+}
+
+int netplay_udp(u16 port, const char *host, u16 remote_port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {0};
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        printf("Failed to open udp port %u\n", port);
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return -1;
+    }
+
+    addr.sin_port = htons(remote_port);
+
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        printf("Failed to reach %s:%u\n", host, remote_port);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool netplay_frame(netplay *np, u8 buttons) {
+    receive(np);
+    confirm(np);
+
+    bool run = np->frame < np->received + np->config.max_rollback;
+
+    if (run) {
+        np->local[np->frame % NETPLAY_HISTORY] = buttons;
+        np->inputs = np->frame + 1;
+    }
+
+    send_inputs(np);
+    flush_queue(np);
+
+    if (run) {
+        run_frame(np, np->frame, true);
+        np->frame++;
+        np->stats.frames++;
+    } else {
+        np->stats.waits++;
+    }
+
+    machine_bind(np->m[np->config.player]);
+    return run;
+}
+
+bool netplay_flush(netplay *np, u32 timeout_ms) {
+    double time = now();
+    double end = time + timeout_ms / 1000.0;
+    double linger = 0;
+
+    //once done the inputs are still sent for a while, the remote might not have the last ones.
+    while (time < end) {
+        receive(np);
+        confirm(np);
+        send_inputs(np);
+        flush_queue(np);
+
+        if (!linger && np->confirmed == np->frame && np->acked >= np->frame) {
+            linger = time + (np->config.latency_ms * 2 + 50) / 1000.0;
+        }
+
+        if (linger && time >= linger) {
+            break;
+        }
+
+        usleep(1000);
+        time = now();
+    }
+
+    machine_bind(np->m[np->config.player]);
+    return linger && time >= linger;
+}
+
+bool netplay_resimulate(netplay *np, u32 frames) {
+    if (frames > np->config.max_rollback || frames > np->frame) {
+        return false;
+    }
+
+    if (frames) {
+        resimulate(np, np->frame - frames);
+    }
+
+    machine_bind(np->m[np->config.player]);
+    return true;
+}
+
+u32 netplay_get_frame(netplay *np) {
+    return np->frame;
+}
+
+u32 netplay_get_confirmed(netplay *np) {
+    return np->confirmed;
+}
+
+u64 netplay_state_hash(netplay *np) {
+    u64 hash = 0;
+
+    for (int i=0; i<2; i++) {
+        machine_bind(np->m[i]);
+        hash = hash * 0x100000001B3ULL ^ state_hash();
+    }
+
+    machine_bind(np->m[np->config.player]);
+    return hash;
+}
+
+void netplay_get_stats(netplay *np, netplay_stats *stats) {
+    *stats = np->stats;
+}
+
+void netplay_free(netplay *np) {
+    if (!np) {
+        return;
+    }
+
+    link_free(np->cable);
+
+    for (int i=1; i>=0; i--) {
+        machine_bind(np->m[i]);
+        gamepad_set_latched(false);
+    }
+
+    for (u32 j=0; j<=np->config.max_rollback; j++) {
+        free(np->states[j][0].data);
+        free(np->states[j][1].data);
+    }
+
+    free(np->queue);
+    free(np);
+}
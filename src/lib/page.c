@@ -0,0 +1,87 @@
+#include <page.h>
+#include <string.h>
+
+mem_page *page_unshare(mem_page **slot) {
+    mem_page *page = *slot;
+    mem_page *copy = malloc(sizeof(mem_page));
+
+    atomic_init(&copy->refs, 1);
+
+    if (page) {
+        memcpy(copy->data, page->data, PAGE_SIZE);
+
+        //the others keep the original.
+        if (atomic_fetch_sub_explicit(&page->refs, 1, memory_order_acq_rel) == 1) {
+            free(page);
+        }
+    } else {
+        memset(copy->data, 0, PAGE_SIZE);
+    }
+
+    *slot = copy;
+    return copy;
+}
+
+void page_read(mem_page **pages, u32 offset, void *dst, u32 size) {
+    u8 *out = dst;
+
+    while (size) {
+        u32 n = PAGE_SIZE - (offset & PAGE_MASK);
+        mem_page *page = pages[offset >> PAGE_SHIFT];
+
+        if (n > size) {
+            n = size;
+        }
+
+        if (page) {
+            memcpy(out, page->data + (offset & PAGE_MASK), n);
+        } else {
+            memset(out, 0, n);
+        }
+
+        out += n;
+        offset += n;
+        size -= n;
+    }
+}
+
+void page_write(mem_page **pages, u32 offset, const void *src, u32 size) {
+    const u8 *in = src;
+
+    while (size) {
+        u32 n = PAGE_SIZE - (offset & PAGE_MASK);
+        mem_page *page = pages[offset >> PAGE_SHIFT];
+
+        if (n > size) {
+            n = size;
+        }
+
+        if (!page || atomic_load_explicit(&page->refs, memory_order_acquire) != 1) {
+            page = page_unshare(&pages[offset >> PAGE_SHIFT]);
+        }
+
+        memcpy(page->data + (offset & PAGE_MASK), in, n);
+
+        in += n;
+        offset += n;
+        size -= n;
+    }
+}
+
+void page_share(mem_page **pages, int count) {
+    for (int i=0; i<count; i++) {
+        if (pages[i]) {
+            atomic_fetch_add_explicit(&pages[i]->refs, 1, memory_order_relaxed);
+        }
+    }
+}
+
+void page_release(mem_page **pages, int count) {
+    for (int i=0; i<count; i++) {
+        if (pages[i] && atomic_fetch_sub_explicit(&pages[i]->refs, 1, memory_order_acq_rel) == 1) {
+            free(pages[i]);
+        }
+
+        pages[i] = NULL;
+    }
+}
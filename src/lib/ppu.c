@@ -2,38 +2,189 @@
 #include <lcd.h>
 #include <string.h>
 #include <ppu_sm.h>
+#include <ppu_deferred.h>
 
-static ppu_context ctx;
+static ppu_context main_ctx;
+
+//each thread works on its own ppu, the render thread of the
+//deferred ppu switches to its own copy with ppu_set_context.
+static _Thread_local ppu_context *ctx = &main_ctx;
 
 ppu_context *ppu_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void ppu_set_context(ppu_context *context) {
+    ctx = context;
 }
 
 void ppu_init() {
-    ctx.current_frame = 0;
-    ctx.line_ticks = 0;
-    ctx.video_buffer = malloc(YRES * XRES * sizeof(u32));
+    ctx->current_frame = 0;
+    ctx->line_ticks = 0;
+    ctx->video_buffer = malloc(YRES * XRES * sizeof(u32));
+
+    ctx->pfc.line_x = 0;
+    ctx->pfc.pushed_x = 0;
+    ctx->pfc.fetch_x = 0;
+    ctx->pfc.pixel_fifo.size = 0;
+    ctx->pfc.pixel_fifo.head = 0;
+    ctx->pfc.cur_fetch_state = FS_TILE;
+
+    ctx->line_sprites = 0;
+    ctx->fetched_entry_count = 0;
+    ctx->window_line = 0;
+
+    ctx->frame_render = true;
+    ctx->next_frame_render = true;
+    ctx->deferred = false;
+    ctx->replay = false;
+    ctx->dots = 0;
+    ctx->changed_frame = 0;
+
+    memset(ctx->line_hash, 0, sizeof(ctx->line_hash));
+    memset(ctx->line_changed, 0, sizeof(ctx->line_changed));
 
-    ctx.pfc.line_x = 0;
-    ctx.pfc.pushed_x = 0;
-    ctx.pfc.fetch_x = 0;
-    ctx.pfc.pixel_fifo.size = 0;
-    ctx.pfc.pixel_fifo.head = ctx.pfc.pixel_fifo.tail = NULL;
-    ctx.pfc.cur_fetch_state = FS_TILE;
+    lcd_init();
+    LCDS_MODE_SET(MODE_OAM);
 
-    ctx.line_sprites = 0;
-    ctx.fetched_entry_count = 0;
-    ctx.window_line = 0;
+    memset(ctx->oam_ram, 0, sizeof(ctx->oam_ram));
+    memset(ctx->video_buffer, 0, YRES * XRES * sizeof(u32));
+}
 
-    lcd_init();
+void ppu_set_frame_render(bool render) {
+    if (render && !ctx->video_buffer) {
+        ctx->video_buffer = calloc(YRES * XRES, sizeof(u32));
+    }
+
+    ctx->next_frame_render = render;
+}
+
+void ppu_copy_context(ppu_context *dst, ppu_context *src) {
+    u32 *video_buffer = dst->video_buffer;
+
+    *dst = *src;
+    dst->video_buffer = video_buffer;
+    page_share(dst->vram, PAGE_COUNT(VRAM_CGB_SIZE));
+
+    //the sprite list points into the ppu's own entry array.
+    for (int i=0; i<10; i++) {
+        oam_line_entry *next = src->line_entry_array[i].next;
+        dst->line_entry_array[i].next = next ?
+            dst->line_entry_array + (next - src->line_entry_array) : NULL;
+    }
+
+    if (src->line_sprites) {
+        dst->line_sprites = dst->line_entry_array + (src->line_sprites - src->line_entry_array);
+    }
+}
+
+static u32 line_hash(u32 *pixels) {
+    //FNV-1a over the line's pixels.
+    u32 hash = 2166136261u;
+
+    for (int x=0; x<XRES; x++) {
+        hash = (hash ^ pixels[x]) * 16777619u;
+    }
+
+    return hash;
+}
+
+void ppu_line_finished(u8 line) {
+    u32 hash = line_hash(ctx->video_buffer + (line * XRES));
+
+    if (hash != ctx->line_hash[line]) {
+        //lines are drawn for the frame that is counted at the next vblank.
+        ctx->line_hash[line] = hash;
+        ctx->line_changed[line] = ctx->current_frame + 1;
+        ctx->changed_frame = ctx->current_frame + 1;
+    }
+}
+
+bool ppu_frame_changed(u32 since_frame, u8 *first_line, u8 *last_line) {
+    if (ctx->changed_frame <= since_frame) {
+        return false;
+    }
+
+    int first = -1;
+    int last = -1;
+
+    for (int y=0; y<YRES; y++) {
+        if (ctx->line_changed[y] > since_frame) {
+            if (first < 0) {
+                first = y;
+            }
+
+            last = y;
+        }
+    }
+
+    if (first < 0) {
+        return false;
+    }
+
+    if (first_line) {
+        *first_line = first;
+    }
+
+    if (last_line) {
+        *last_line = last;
+    }
+
+    return true;
+}
+
+void ppu_lcd_disable() {
+    //the ppu stays dormant until the lcd is switched back on,
+    //ly is held at 0 in mode 0 and no interrupts are raised. line_ticks
+    //counts the dots of the frames that still pass.
+    pipeline_fifo_reset();
+
+    ctx->line_ticks = 0;
+    ctx->window_line = 0;
+    lcd_get_context()->ly = 0;
+    LCDS_MODE_SET(MODE_HBLANK);
+
+    if (ctx->deferred || !ctx->video_buffer) {
+        //the render thread blanks its own buffer and hands it over at once.
+        return;
+    }
+
+    //screen goes blank while the lcd is off.
+    for (int i=0; i<YRES * XRES; i++) {
+        ctx->video_buffer[i] = 0xFFFFFFFF;
+    }
+
+    for (int y=0; y<YRES; y++) {
+        ppu_line_finished(y);
+    }
+}
+
+void ppu_lcd_enable() {
+    //restart from the beginning of line 0 on the next tick.
+    ctx->line_ticks = 0;
+    ctx->window_line = 0;
+    lcd_get_context()->ly = 0;
     LCDS_MODE_SET(MODE_OAM);
 
-    memset(ctx.oam_ram, 0, sizeof(ctx.oam_ram));
-    memset(ctx.video_buffer, 0, YRES * XRES * sizeof(u32));
+    //the first frame after the lcd is switched on is not displayed.
+    ctx->frame_render = false;
 }
 
 void ppu_tick() {
-    ctx.line_ticks++;
+    ctx->dots++;
+
+    if (!LCDC_LCD_ENABLE) {
+        //nothing is drawn while the lcd is off, but the frames are still
+        //counted so pacing, movies, rewind and run-ahead go on.
+        if (++ctx->line_ticks >= (u32)(LINES_PER_FRAME * TICKS_PER_LINE)) {
+            ctx->line_ticks = 0;
+            ctx->current_frame++;
+        }
+
+        return;
+    }
+
+    ctx->line_ticks++;
 
     switch(LCDS_MODE) {
     case MODE_OAM:
@@ -49,6 +200,11 @@ void ppu_tick() {
         ppu_mode_hblank();
         break;
     }
+
+    if (ctx->deferred && ctx->line_ticks == 0) {
+        //a line was completed, let the render thread know.
+        ppu_deferred_line_end();
+    }
 }
 
 
@@ -57,8 +213,12 @@ void ppu_oam_write(u16 address, u8 value) {
         address -= 0xFE00;
     }
 
-    u8 *p = (u8 *)ctx.oam_ram;
+    u8 *p = (u8 *)ctx->oam_ram;
     p[address] = value;
+
+    if (ctx->deferred) {
+        ppu_deferred_log(0xFE00 + address, value);
+    }
 }
 
 u8 ppu_oam_read(u16 address) {
@@ -66,14 +226,29 @@ u8 ppu_oam_read(u16 address) {
         address -= 0xFE00;
     }
 
-    u8 *p = (u8 *)ctx.oam_ram;
+    u8 *p = (u8 *)ctx->oam_ram;
     return p[address];
 }
 
 void ppu_vram_write(u16 address, u8 value) {
-    ctx.vram[address - 0x8000] = value;
+    //the render thread replays VBK writes too, so it picks the same bank.
+    page_write_u8(ctx->vram, (address - 0x8000) + lcd_get_context()->vbk * VRAM_SIZE, value);
+
+    if (ctx->deferred) {
+        ppu_deferred_log(address, value);
+    }
+}
+
+void ppu_vram_write_block(u16 address, const u8 *data, u16 len) {
+    page_write(ctx->vram, (address - 0x8000) + lcd_get_context()->vbk * VRAM_SIZE, data, len);
+
+    if (ctx->deferred) {
+        for (int i=0; i<len; i++) {
+            ppu_deferred_log(address + i, data[i]);
+        }
+    }
 }
 
 u8 ppu_vram_read(u16 address) {
-    return ctx.vram[address - 0x8000];
+    return page_read_u8(ctx->vram, (address - 0x8000) + lcd_get_context()->vbk * VRAM_SIZE);
 }
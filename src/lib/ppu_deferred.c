@@ -0,0 +1,220 @@
+#include <ppu_deferred.h>
+#include <ppu.h>
+#include <lcd.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define LOG_SIZE (1 << 16)
+#define LOG_MASK (LOG_SIZE - 1)
+
+typedef struct {
+    u64 dot; //ppu dot the write happened on.
+    u16 address;
+    u8 value;
+} ppu_log_entry;
+
+typedef struct {
+    bool active;
+    ppu_sync sync;
+    pthread_t thread;
+    atomic_bool running;
+
+    //single producer (emulation thread), single consumer (render thread).
+    ppu_log_entry entries[LOG_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+
+    atomic_ullong safe_dots; //render thread may tick up to this dot.
+    atomic_ullong rendered_dots; //dots the render thread has completed.
+
+    ppu_context *main_ppu;
+    ppu_context render_ppu;
+    lcd_context render_lcd;
+} ppu_deferred_context;
+
+static ppu_deferred_context ctx;
+
+static void publish() {
+    atomic_store_explicit(&ctx.safe_dots, ctx.main_ppu->dots, memory_order_release);
+}
+
+static void apply_entry(ppu_log_entry *e) {
+    if (e->address < 0xA000) {
+        ppu_vram_write(e->address, e->value);
+    } else if (e->address < 0xFF00) {
+        ppu_oam_write(e->address, e->value);
+    } else {
+        lcd_write(e->address, e->value);
+    }
+}
+
+static void *render_run(void *p) {
+    ppu_set_context(&ctx.render_ppu);
+    lcd_set_context(&ctx.render_lcd);
+
+    u32 tail = atomic_load_explicit(&ctx.tail, memory_order_relaxed);
+    u32 prev_frame = ctx.render_ppu.current_frame;
+    u8 first_line, last_line;
+    int idle = 0;
+
+    while (atomic_load_explicit(&ctx.running, memory_order_acquire)) {
+        u64 target = atomic_load_explicit(&ctx.safe_dots, memory_order_acquire);
+
+        if (ctx.render_ppu.dots >= target) {
+            //nothing to render yet.
+            if (++idle < 64) {
+                sched_yield();
+            } else {
+                usleep(50);
+            }
+
+            continue;
+        }
+
+        idle = 0;
+        u32 head = atomic_load_explicit(&ctx.head, memory_order_acquire);
+
+        while (ctx.render_ppu.dots < target) {
+            bool lcd_on = BIT(ctx.render_lcd.lcdc, 7);
+
+            //apply every write that happened before the next dot.
+            while (tail != head && ctx.entries[tail & LOG_MASK].dot <= ctx.render_ppu.dots) {
+                apply_entry(&ctx.entries[tail & LOG_MASK]);
+                tail++;
+            }
+
+            ppu_tick();
+
+            //switching the lcd off blanks the screen right away, not at the next frame.
+            bool lcd_off = lcd_on && !BIT(ctx.render_lcd.lcdc, 7);
+
+            if (lcd_off || prev_frame != ctx.render_ppu.current_frame) {
+                //copy the lines that changed since the last frame.
+                if (ppu_frame_changed(prev_frame, &first_line, &last_line)) {
+                    u32 offset = first_line * XRES;
+
+                    memcpy(ctx.main_ppu->video_buffer + offset, ctx.render_ppu.video_buffer + offset,
+                        (last_line - first_line + 1) * XRES * sizeof(u32));
+                    memcpy(ctx.main_ppu->line_changed, ctx.render_ppu.line_changed,
+                        sizeof(ctx.main_ppu->line_changed));
+                    ctx.main_ppu->changed_frame = ctx.render_ppu.changed_frame;
+                }
+
+                prev_frame = ctx.render_ppu.current_frame;
+            }
+        }
+
+        atomic_store_explicit(&ctx.tail, tail, memory_order_release);
+        atomic_store_explicit(&ctx.rendered_dots, ctx.render_ppu.dots, memory_order_release);
+    }
+
+    return 0;
+}
+
+void ppu_deferred_start(ppu_sync sync) {
+    if (ctx.active) {
+        ppu_deferred_stop();
+    }
+
+    ctx.sync = sync;
+    ctx.main_ppu = ppu_get_context();
+
+    //the render thread starts from a copy of the freshly initialized ppu.
+    u32 *render_buffer = ctx.render_ppu.video_buffer;
+
+    if (!render_buffer) {
+        render_buffer = malloc(YRES * XRES * sizeof(u32));
+    }
+
+    //vram pages are shared until either side writes them.
+    ctx.render_ppu.video_buffer = render_buffer;
+    ppu_copy_context(&ctx.render_ppu, ctx.main_ppu);
+
+    ctx.render_ppu.replay = true;
+    memcpy(render_buffer, ctx.main_ppu->video_buffer, YRES * XRES * sizeof(u32));
+    ctx.render_lcd = *lcd_get_context();
+
+    ctx.main_ppu->deferred = true;
+    ctx.main_ppu->frame_render = false;
+
+    atomic_store(&ctx.head, 0);
+    atomic_store(&ctx.tail, 0);
+    atomic_store(&ctx.safe_dots, ctx.main_ppu->dots);
+    atomic_store(&ctx.rendered_dots, ctx.main_ppu->dots);
+    atomic_store(&ctx.running, true);
+
+    if (pthread_create(&ctx.thread, NULL, render_run, NULL)) {
+        fprintf(stderr, "FAILED TO START PPU RENDER THREAD!\n");
+        ctx.main_ppu->deferred = false;
+        return;
+    }
+
+    ctx.active = true;
+}
+
+void ppu_deferred_stop() {
+    if (!ctx.active) {
+        return;
+    }
+
+    ppu_deferred_flush();
+
+    atomic_store_explicit(&ctx.running, false, memory_order_release);
+    pthread_join(ctx.thread, NULL);
+
+    ctx.main_ppu->deferred = false;
+    ctx.active = false;
+
+    page_release(ctx.render_ppu.vram, PAGE_COUNT(VRAM_CGB_SIZE));
+}
+
+void ppu_deferred_restart() {
+    ppu_deferred_start(ctx.sync);
+}
+
+bool ppu_deferred_active() {
+    return ctx.active;
+}
+
+ppu_context *ppu_deferred_render_context() {
+    return ctx.active ? &ctx.render_ppu : NULL;
+}
+
+void ppu_deferred_flush() {
+    if (!ctx.active) {
+        return;
+    }
+
+    publish();
+
+    while (atomic_load_explicit(&ctx.rendered_dots, memory_order_acquire) < ctx.main_ppu->dots) {
+        sched_yield();
+    }
+}
+
+void ppu_deferred_log(u16 address, u8 value) {
+    u32 head = atomic_load_explicit(&ctx.head, memory_order_relaxed);
+
+    while (head - atomic_load_explicit(&ctx.tail, memory_order_acquire) >= LOG_SIZE) {
+        //log is full, let the render thread catch up.
+        publish();
+        sched_yield();
+    }
+
+    ppu_log_entry *e = &ctx.entries[head & LOG_MASK];
+    e->dot = ctx.main_ppu->dots;
+    e->address = address;
+    e->value = value;
+
+    atomic_store_explicit(&ctx.head, head + 1, memory_order_release);
+}
+
+void ppu_deferred_line_end() {
+    if (ctx.sync == PPU_SYNC_LINE || lcd_get_context()->ly == YRES) {
+        publish();
+    }
+}
@@ -1,6 +1,5 @@
 #include <ppu.h>
 #include <lcd.h>
-#include <bus.h>
 
 bool window_visible() {
     return LCDC_WIN_ENABLE && lcd_get_context()->win_x >= 0 &&
@@ -9,38 +8,28 @@ bool window_visible() {
 }
 
 void pixel_fifo_push(u32 value) {
-    fifo_entry *next = malloc(sizeof(fifo_entry));
-    next->next = NULL;
-    next->value = value;
-
-    if (!ppu_get_context()->pfc.pixel_fifo.head) {
-        //first entry...
-        ppu_get_context()->pfc.pixel_fifo.head = ppu_get_context()->pfc.pixel_fifo.tail = next;
-    } else {
-        ppu_get_context()->pfc.pixel_fifo.tail->next = next;
-        ppu_get_context()->pfc.pixel_fifo.tail = next;
-    }
+    fifo *f = &ppu_get_context()->pfc.pixel_fifo;
 
-    ppu_get_context()->pfc.pixel_fifo.size++;
+    f->entries[(f->head + f->size) & (PIXEL_FIFO_SIZE - 1)] = value;
+    f->size++;
 }
 
 u32 pixel_fifo_pop() {
-    if (ppu_get_context()->pfc.pixel_fifo.size <= 0) {
+    fifo *f = &ppu_get_context()->pfc.pixel_fifo;
+
+    if (f->size <= 0) {
         fprintf(stderr, "ERR IN PIXEL FIFO!\n");
         exit(-8);
     }
 
-    fifo_entry *popped = ppu_get_context()->pfc.pixel_fifo.head;
-    ppu_get_context()->pfc.pixel_fifo.head = popped->next;
-    ppu_get_context()->pfc.pixel_fifo.size--;
-
-    u32 val = popped->value;
-    free(popped);
+    u32 val = f->entries[f->head];
+    f->head = (f->head + 1) & (PIXEL_FIFO_SIZE - 1);
+    f->size--;
 
     return val;
 }
 
-u32 fetch_sprite_pixels(int bit, u32 color, u8 bg_color) {
+u32 fetch_sprite_pixels(int bit, u32 color, u8 bg_color, u8 bg_attr) {
     for (int i=0; i<ppu_get_context()->fetched_entry_count; i++) {
         int sp_x = (ppu_get_context()->fetched_entries[i].x - 8) +
             ((lcd_get_context()->scroll_x % 8));
@@ -73,9 +62,19 @@ u32 fetch_sprite_pixels(int bit, u32 color, u8 bg_color) {
             continue;
         }
 
+        if (lcd_get_context()->cgb) {
+            //the tile can take priority too, unless LCDC bit 0 takes it
+            //away from the bg and the window.
+            bg_priority = LCDC_BGW_ENABLE && (bg_priority || (bg_attr & BG_ATTR_PRIORITY));
+        }
+
         if (!bg_priority || bg_color == 0) {
-            color = (ppu_get_context()->fetched_entries[i].f_pn) ?
-                lcd_get_context()->sp2_colors[hi|lo] : lcd_get_context()->sp1_colors[hi|lo];
+            if (lcd_get_context()->cgb) {
+                color = lcd_get_context()->sp_cgb_colors[ppu_get_context()->fetched_entries[i].f_cgb_pn][hi|lo];
+            } else {
+                color = (ppu_get_context()->fetched_entries[i].f_pn) ?
+                    lcd_get_context()->sp2_colors[hi|lo] : lcd_get_context()->sp1_colors[hi|lo];
+            }
 
             if (hi|lo) {
                 break;
@@ -94,18 +93,23 @@ bool pipeline_fifo_add() {
 
     int x = ppu_get_context()->pfc.fetch_x - (8 - (lcd_get_context()->scroll_x % 8));
 
+    //always 0 on a dmg.
+    u8 attr = ppu_get_context()->pfc.bgw_fetch_attr;
+    u32 *colors = lcd_get_context()->cgb ?
+        lcd_get_context()->bg_cgb_colors[attr & 0b111] : lcd_get_context()->bg_colors;
+
     for (int i=0; i<8; i++) {
-        int bit = 7 - i;
+        int bit = (attr & BG_ATTR_X_FLIP) ? i : 7 - i;
         u8 hi = !!(ppu_get_context()->pfc.bgw_fetch_data[1] & (1 << bit));
         u8 lo = !!(ppu_get_context()->pfc.bgw_fetch_data[2] & (1 << bit)) << 1;
-        u32 color = lcd_get_context()->bg_colors[hi | lo];
+        u32 color = colors[hi | lo];
 
-        if (!LCDC_BGW_ENABLE) {
+        if (!LCDC_BGW_ENABLE && !lcd_get_context()->cgb) {
             color = lcd_get_context()->bg_colors[0];
         }
 
         if (LCDC_OBJ_ENABLE) {
-            color = fetch_sprite_pixels(bit, color, hi | lo);
+            color = fetch_sprite_pixels(bit, color, hi | lo, attr);
         }
 
         if (x >= 0) {
@@ -151,13 +155,14 @@ void pipeline_load_sprite_data(u8 offset) {
         }
 
         u8 tile_index = ppu_get_context()->fetched_entries[i].tile;
+        u8 bank = lcd_get_context()->cgb ? ppu_get_context()->fetched_entries[i].f_cgb_vram_bank : 0;
 
         if (sprite_height == 16) {
             tile_index &= ~(1); //remove last bit...
         }
 
         ppu_get_context()->pfc.fetch_entry_data[(i * 2) + offset] =
-            bus_read(0x8000 + (tile_index * 16) + ty + offset);
+            ppu_vram_bank_read(ppu_get_context(), bank, 0x8000 + (tile_index * 16) + ty + offset);
     }
 }
 
@@ -172,10 +177,15 @@ void pipeline_load_window_tile() {
             ppu_get_context()->pfc.fetch_x + 7 < lcd_get_context()->win_x + YRES + 14) {
         if (lcd_get_context()->ly >= window_y && lcd_get_context()->ly < window_y + XRES) {
             u8 w_tile_y = ppu_get_context()->window_line / 8;
-
-            ppu_get_context()->pfc.bgw_fetch_data[0] = bus_read(LCDC_WIN_MAP_AREA + 
+            u16 map_address = LCDC_WIN_MAP_AREA +
                 ((ppu_get_context()->pfc.fetch_x + 7 - lcd_get_context()->win_x) / 8) +
-                (w_tile_y * 32));
+                (w_tile_y * 32);
+
+            ppu_get_context()->pfc.bgw_fetch_data[0] = ppu_vram_bank_read(ppu_get_context(), 0, map_address);
+
+            if (lcd_get_context()->cgb) {
+                ppu_get_context()->pfc.bgw_fetch_attr = ppu_vram_bank_read(ppu_get_context(), 1, map_address);
+            }
 
             if (LCDC_BGW_DATA_AREA == 0x8800) {
                 ppu_get_context()->pfc.bgw_fetch_data[0] += 128;
@@ -184,15 +194,35 @@ void pipeline_load_window_tile() {
     }
 }
 
+//a row of the fetched bg/window tile, flipped and banked by its attributes.
+static u8 bgw_data_read(u8 offset) {
+    u8 attr = ppu_get_context()->pfc.bgw_fetch_attr;
+    u8 ty = ppu_get_context()->pfc.tile_y;
+
+    if (attr & BG_ATTR_Y_FLIP) {
+        ty = 14 - ty;
+    }
+
+    return ppu_vram_bank_read(ppu_get_context(), !!(attr & BG_ATTR_BANK), LCDC_BGW_DATA_AREA +
+        (ppu_get_context()->pfc.bgw_fetch_data[0] * 16) + ty + offset);
+}
+
 void pipeline_fetch() {
     switch(ppu_get_context()->pfc.cur_fetch_state) {
         case FS_TILE: {
             ppu_get_context()->fetched_entry_count = 0;
 
-            if (LCDC_BGW_ENABLE) {
-                ppu_get_context()->pfc.bgw_fetch_data[0] = bus_read(LCDC_BG_MAP_AREA +
+            //on a cgb LCDC bit 0 only takes away the bg's priority.
+            if (LCDC_BGW_ENABLE || lcd_get_context()->cgb) {
+                u16 map_address = LCDC_BG_MAP_AREA +
                     (ppu_get_context()->pfc.map_x / 8) +
-                    (((ppu_get_context()->pfc.map_y / 8)) * 32));
+                    (((ppu_get_context()->pfc.map_y / 8)) * 32);
+
+                ppu_get_context()->pfc.bgw_fetch_data[0] = ppu_vram_bank_read(ppu_get_context(), 0, map_address);
+
+                if (lcd_get_context()->cgb) {
+                    ppu_get_context()->pfc.bgw_fetch_attr = ppu_vram_bank_read(ppu_get_context(), 1, map_address);
+                }
 
                 if (LCDC_BGW_DATA_AREA == 0x8800) {
                     ppu_get_context()->pfc.bgw_fetch_data[0] += 128;
@@ -210,18 +240,14 @@ void pipeline_fetch() {
         } break;
 
         case FS_DATA0: {
-            ppu_get_context()->pfc.bgw_fetch_data[1] = bus_read(LCDC_BGW_DATA_AREA +
-                (ppu_get_context()->pfc.bgw_fetch_data[0] * 16) +
-                ppu_get_context()->pfc.tile_y);
+            ppu_get_context()->pfc.bgw_fetch_data[1] = bgw_data_read(0);
 
             pipeline_load_sprite_data(0);
 
             ppu_get_context()->pfc.cur_fetch_state = FS_DATA1;
         } break;
         case FS_DATA1: {
-            ppu_get_context()->pfc.bgw_fetch_data[2] = bus_read(LCDC_BGW_DATA_AREA +
-                (ppu_get_context()->pfc.bgw_fetch_data[0] * 16) +
-                ppu_get_context()->pfc.tile_y + 1);
+            ppu_get_context()->pfc.bgw_fetch_data[2] = bgw_data_read(1);
 
             pipeline_load_sprite_data(1);
 
@@ -270,11 +296,56 @@ void pipeline_process() {
     pipeline_push_pixel();
 }
 
-void pipeline_fifo_reset() {
-    while(ppu_get_context()->pfc.pixel_fifo.size) {
-        pixel_fifo_pop();
+void pipeline_skip_process() {
+    //same fetcher/fifo timing as pipeline_process, but only the fifo size is
+    //tracked. no vram is read and nothing is written to the video buffer.
+    if (!(ppu_get_context()->line_ticks & 1)) {
+        switch(ppu_get_context()->pfc.cur_fetch_state) {
+            case FS_TILE:
+                ppu_get_context()->pfc.cur_fetch_state = FS_DATA0;
+                ppu_get_context()->pfc.fetch_x += 8;
+                break;
+            case FS_DATA0:
+                ppu_get_context()->pfc.cur_fetch_state = FS_DATA1;
+                break;
+            case FS_DATA1:
+                ppu_get_context()->pfc.cur_fetch_state = FS_IDLE;
+                break;
+            case FS_IDLE:
+                ppu_get_context()->pfc.cur_fetch_state = FS_PUSH;
+                break;
+            case FS_PUSH: {
+                if (ppu_get_context()->pfc.pixel_fifo.size > 8) {
+                    //fifo is full!
+                    break;
+                }
+
+                int x = ppu_get_context()->pfc.fetch_x - (8 - (lcd_get_context()->scroll_x % 8));
+
+                if (x >= 0) {
+                    ppu_get_context()->pfc.pixel_fifo.size += 8;
+                    ppu_get_context()->pfc.fifo_x += 8;
+                }
+
+                ppu_get_context()->pfc.cur_fetch_state = FS_TILE;
+            } break;
+        }
     }
 
+    if (ppu_get_context()->pfc.pixel_fifo.size > 8) {
+        ppu_get_context()->pfc.pixel_fifo.head = (ppu_get_context()->pfc.pixel_fifo.head + 1) & (PIXEL_FIFO_SIZE - 1);
+        ppu_get_context()->pfc.pixel_fifo.size--;
+
+        if (ppu_get_context()->pfc.line_x >= (lcd_get_context()->scroll_x % 8)) {
+            ppu_get_context()->pfc.pushed_x++;
+        }
+
+        ppu_get_context()->pfc.line_x++;
+    }
+}
+
+void pipeline_fifo_reset() {
+    ppu_get_context()->pfc.pixel_fifo.size = 0;
     ppu_get_context()->pfc.pixel_fifo.head = 0;
 }
 
@@ -4,12 +4,16 @@
 #include <interrupts.h>
 #include <string.h>
 #include <cart.h>
+#include <dma.h>
 
-static u32 target_frame_time = 1000 / 60;
-static long prev_frame_time = 0;
-static long start_timer = 0;
-static long frame_count = 0;
-u32 fps = 0;
+static void ppu_request_interrupt(interrupt_type t) {
+    if (ppu_get_context()->replay) {
+        //the render thread only draws, interrupts come from the emulation thread.
+        return;
+    }
+
+    cpu_request_interrupt(t);
+}
 
 void increment_ly() {
     if (window_visible() && lcd_get_context()->ly >= lcd_get_context()->win_y &&
@@ -23,7 +27,7 @@ void increment_ly() {
         LCDS_LYC_SET(1);
 
         if (LCDS_STAT_INT(SS_LYC)) {
-            cpu_request_interrupt(IT_LCD_STAT);
+            ppu_request_interrupt(IT_LCD_STAT);
         }
     } else {
         LCDS_LYC_SET(0);
@@ -34,6 +38,10 @@ void load_line_sprites() {
     int cur_y = lcd_get_context()->ly;
 
     u8 sprite_height = LCDC_OBJ_HEIGHT;
+
+    //a cgb keeps the oam order, a dmg sorts by x.
+    bool by_x = !lcd_get_context()->cgb;
+
     memset(ppu_get_context()->line_entry_array, 0,
         sizeof(ppu_get_context()->line_entry_array));
 
@@ -61,7 +69,7 @@ void load_line_sprites() {
             entry->next = NULL;
 
             if (!ppu_get_context()->line_sprites ||
-                    ppu_get_context()->line_sprites->entry.x > e.x) {
+                    (by_x && ppu_get_context()->line_sprites->entry.x > e.x)) {
                 entry->next = ppu_get_context()->line_sprites;
                 ppu_get_context()->line_sprites = entry;
                 continue;
@@ -73,7 +81,7 @@ void load_line_sprites() {
             oam_line_entry *prev = le;
 
             while(le) {
-                if (le->entry.x > e.x) {
+                if (by_x && le->entry.x > e.x) {
                     prev->next = entry;
                     entry->next = le;
                     break;
@@ -102,7 +110,7 @@ void ppu_mode_oam() {
         ppu_get_context()->pfc.fifo_x = 0;
     }
 
-    if (ppu_get_context()->line_ticks == 1) {
+    if (ppu_get_context()->line_ticks == 1 && ppu_get_context()->frame_render) {
         //read oam on the first tick only...
         ppu_get_context()->line_sprites = 0;
         ppu_get_context()->line_sprite_count = 0;
@@ -112,15 +120,28 @@ void ppu_mode_oam() {
 }
 
 void ppu_mode_xfer() {
-    pipeline_process();
+    if (ppu_get_context()->frame_render) {
+        pipeline_process();
+    } else {
+        pipeline_skip_process();
+    }
 
     if (ppu_get_context()->pfc.pushed_x >= XRES) {
         pipeline_fifo_reset();
 
+        if (ppu_get_context()->frame_render) {
+            ppu_line_finished(lcd_get_context()->ly);
+        }
+
         LCDS_MODE_SET(MODE_HBLANK);
 
         if (LCDS_STAT_INT(SS_HBLANK)) {
-            cpu_request_interrupt(IT_LCD_STAT);
+            ppu_request_interrupt(IT_LCD_STAT);
+        }
+
+        if (!ppu_get_context()->replay) {
+            //the render thread gets the copied bytes from the log.
+            dma_hblank();
         }
     }
 }
@@ -133,6 +154,9 @@ void ppu_mode_vblank() {
             LCDS_MODE_SET(MODE_OAM);
             lcd_get_context()->ly = 0;
             ppu_get_context()->window_line = 0;
+
+            ppu_get_context()->frame_render = ppu_get_context()->next_frame_render &&
+                !ppu_get_context()->deferred;
         }
 
         ppu_get_context()->line_ticks = 0;
@@ -146,31 +170,13 @@ void ppu_mode_hblank() {
         if (lcd_get_context()->ly >= YRES) {
             LCDS_MODE_SET(MODE_VBLANK);
 
-            cpu_request_interrupt(IT_VBLANK);
+            ppu_request_interrupt(IT_VBLANK);
 
             if (LCDS_STAT_INT(SS_VBLANK)) {
-                cpu_request_interrupt(IT_LCD_STAT);
+                ppu_request_interrupt(IT_LCD_STAT);
             }
 
             ppu_get_context()->current_frame++;
-
-            //calc FPS...
-            u64 end = get_ticks();
-            u64 frame_time = end - prev_frame_time;
-
-            if (frame_time < target_frame_time) {
-                delay((target_frame_time - frame_time));
-            }
-
-            if (end - start_timer >= 1000) {
-                fps = frame_count;
-                start_timer = end;
-                frame_count = 0;
-            }
-
-            frame_count++;
-            prev_frame_time = get_ticks();
-
         } else {
             LCDS_MODE_SET(MODE_OAM);
         }
@@ -1,6 +1,15 @@
 #include <ram.h>
 
-static ram_context ctx;
+static ram_context main_ctx;
+static _Thread_local ram_context *ctx = &main_ctx;
+
+ram_context *ram_get_context() {
+    return ctx;
+}
+
+void ram_set_context(ram_context *context) {
+    ctx = context;
+}
 
 u8 wram_read(u16 address) {
     address -= 0xC000;
@@ -9,23 +18,42 @@ u8 wram_read(u16 address) {
         exit(-8);
     }
 
-    return ctx.wram[address];
+    if (address >= WRAM_BANK_SIZE) {
+        address += ctx->wram_offset;
+    }
+
+    return page_read_u8(ctx->wram, address);
 }
 
 void wram_write(u16 address, u8 value) {
     address -= 0xC000;
 
-    ctx.wram[address] = value;
+    if (address >= WRAM_BANK_SIZE) {
+        address += ctx->wram_offset;
+    }
+
+    page_write_u8(ctx->wram, address, value);
 }
 
 u8 hram_read(u16 address) {
     address -= 0xFF80;
 
-    return ctx.hram[address];
+    return ctx->hram[address];
 }
 
 void hram_write(u16 address, u8 value) {
     address -= 0xFF80;
 
-    ctx.hram[address] = value;
+    ctx->hram[address] = value;
+}
+
+u8 ram_svbk_read() {
+    return ctx->svbk;
+}
+
+void ram_svbk_write(u8 value) {
+    u8 bank = value & 0b111;
+
+    ctx->svbk = bank;
+    ctx->wram_offset = bank ? (bank - 1) * WRAM_BANK_SIZE : 0;
 }
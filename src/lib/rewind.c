@@ -0,0 +1,293 @@
+#include <rewind.h>
+#include <state.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    u32 offset;
+    u32 size;
+} rewind_entry;
+
+typedef struct {
+    bool enabled;
+
+    //encoded deltas, oldest first, wrapping around at the end.
+    u8 *ring;
+    u32 budget;
+    u32 write_pos;
+    u32 bytes_used;
+
+    rewind_entry *entries;
+    u32 capacity;
+    u32 first;
+    u32 count;
+
+    //the newest state is kept whole.
+    u32 state_size;
+    u8 *last;
+    u8 *cur;
+    u8 *scratch;
+    bool have_last;
+
+    u64 pushes;
+    double encode_time;
+    u64 steps;
+    double decode_time;
+} rewind_context;
+
+static rewind_context ctx;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static u64 load64(const u8 *p) {
+    u64 v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static u32 put_varint(u8 *out, u32 value) {
+    u32 n = 0;
+
+    while (value >= 0x80) {
+        out[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+
+    out[n++] = value;
+    return n;
+}
+
+static u32 get_varint(const u8 *in, u32 *pos) {
+    u32 value = 0;
+    int shift = 0;
+    u8 b;
+
+    do {
+        b = in[(*pos)++];
+        value |= (u32)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    return value;
+}
+
+//runs of (equal bytes to skip, length, xor of the differing bytes).
+static u32 encode_delta(const u8 *a, const u8 *b, u32 size, u8 *out) {
+    u32 pos = 0;
+    u32 o = 0;
+
+    while (pos < size) {
+        u32 start = pos;
+
+        while (pos + 8 <= size && load64(a + pos) == load64(b + pos)) {
+            pos += 8;
+        }
+
+        while (pos < size && a[pos] == b[pos]) {
+            pos++;
+        }
+
+        if (pos == size) {
+            break;
+        }
+
+        u32 skip = pos - start;
+        start = pos;
+
+        //the literal ends on the next whole equal word.
+        while (pos + 8 <= size && load64(a + pos) != load64(b + pos)) {
+            pos += 8;
+        }
+
+        if (pos + 8 > size) {
+            pos = size;
+        }
+
+        o += put_varint(out + o, skip);
+        o += put_varint(out + o, pos - start);
+
+        for (u32 i=start; i<pos; i++) {
+            out[o++] = a[i] ^ b[i];
+        }
+    }
+
+    return o;
+}
+
+static void apply_delta(u8 *state, const u8 *delta, u32 size) {
+    u32 o = 0;
+    u32 pos = 0;
+
+    while (o < size) {
+        pos += get_varint(delta, &o);
+        u32 len = get_varint(delta, &o);
+
+        for (u32 i=0; i<len; i++) {
+            state[pos + i] ^= delta[o + i];
+        }
+
+        o += len;
+        pos += len;
+    }
+}
+
+static void drop_oldest() {
+    ctx.bytes_used -= ctx.entries[ctx.first].size;
+    ctx.first = (ctx.first + 1) % ctx.capacity;
+    ctx.count--;
+}
+
+static bool oldest_overlaps(u32 pos, u32 size) {
+    rewind_entry *e = &ctx.entries[ctx.first];
+    return e->offset < pos + size && pos < e->offset + e->size;
+}
+
+static void store_delta(const u8 *delta, u32 size) {
+    if (size > ctx.budget) {
+        //can't be stored, the history before it is useless.
+        rewind_clear();
+        return;
+    }
+
+    u32 pos = ctx.write_pos;
+
+    if (pos + size > ctx.budget) {
+        //wrap around, everything behind the write position is the oldest.
+        while (ctx.count && ctx.entries[ctx.first].offset >= pos) {
+            drop_oldest();
+        }
+
+        pos = 0;
+    }
+
+    while (ctx.count && (ctx.count == ctx.capacity || oldest_overlaps(pos, size))) {
+        drop_oldest();
+    }
+
+    memcpy(ctx.ring + pos, delta, size);
+
+    rewind_entry *e = &ctx.entries[(ctx.first + ctx.count) % ctx.capacity];
+    e->offset = pos;
+    e->size = size;
+    ctx.count++;
+    ctx.bytes_used += size;
+    ctx.write_pos = pos + size;
+}
+
+bool rewind_init(u32 budget) {
+    rewind_free();
+
+    ctx.budget = budget;
+    ctx.ring = malloc(budget);
+    //an unchanged frame still takes a few bytes.
+    ctx.capacity = budget / 16;
+    ctx.entries = malloc(ctx.capacity * sizeof(rewind_entry));
+
+    if (!ctx.ring || !ctx.entries || !ctx.capacity) {
+        fprintf(stderr, "Failed to allocate rewind buffer\n");
+        rewind_free();
+        return false;
+    }
+
+    ctx.enabled = true;
+    rewind_clear();
+
+    return true;
+}
+
+void rewind_free() {
+    free(ctx.ring);
+    free(ctx.entries);
+    free(ctx.last);
+    free(ctx.cur);
+    free(ctx.scratch);
+
+    memset(&ctx, 0, sizeof(ctx));
+}
+
+bool rewind_enabled() {
+    return ctx.enabled;
+}
+
+void rewind_clear() {
+    ctx.write_pos = 0;
+    ctx.bytes_used = 0;
+    ctx.first = 0;
+    ctx.count = 0;
+    ctx.have_last = false;
+}
+
+void rewind_push() {
+    if (!ctx.enabled) {
+        return;
+    }
+
+    double start = now();
+
+    //the size is only queried again when a save doesn't fit, it stays
+    //the same until another rom or cartridge ram size is loaded.
+    u32 size = ctx.state_size ? state_save(ctx.cur, ctx.state_size) : 0;
+
+    if (!size || size != ctx.state_size) {
+        if (!size) {
+            size = state_size();
+        }
+
+        ctx.state_size = size;
+        ctx.last = realloc(ctx.last, size);
+        ctx.cur = realloc(ctx.cur, size);
+        ctx.scratch = realloc(ctx.scratch, size * 2 + 16);
+        rewind_clear();
+
+        state_save(ctx.cur, size);
+    }
+
+    if (ctx.have_last) {
+        store_delta(ctx.scratch, encode_delta(ctx.last, ctx.cur, size, ctx.scratch));
+    }
+
+    u8 *tmp = ctx.last;
+    ctx.last = ctx.cur;
+    ctx.cur = tmp;
+    ctx.have_last = true;
+
+    ctx.pushes++;
+    ctx.encode_time += now() - start;
+}
+
+bool rewind_step_back() {
+    if (!ctx.enabled || !ctx.count) {
+        return false;
+    }
+
+    double start = now();
+    rewind_entry *e = &ctx.entries[(ctx.first + ctx.count - 1) % ctx.capacity];
+
+    apply_delta(ctx.last, ctx.ring + e->offset, e->size);
+
+    ctx.bytes_used -= e->size;
+    ctx.write_pos = e->offset;
+    ctx.count--;
+
+    bool loaded = state_load(ctx.last, ctx.state_size);
+
+    ctx.steps++;
+    ctx.decode_time += now() - start;
+
+    return loaded;
+}
+
+void rewind_get_stats(rewind_stats *stats) {
+    stats->frames = ctx.count;
+    stats->bytes_used = ctx.bytes_used;
+    stats->budget = ctx.budget;
+    stats->seconds = ctx.count / 60.0;
+    stats->bytes_per_second = ctx.count ? ctx.bytes_used / stats->seconds : 0;
+    stats->encode_us = ctx.pushes ? (ctx.encode_time / ctx.pushes) * 1e6 : 0;
+    stats->decode_us = ctx.steps ? (ctx.decode_time / ctx.steps) * 1e6 : 0;
+}
@@ -0,0 +1,257 @@
+#include <rom.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HASH_INIT 0xCBF29CE484222325ULL
+#define HASH_PRIME 0x100000001B3ULL
+
+//the cart reads the first two banks without checking the size.
+#define ROM_MIN_SIZE 0x8000
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static rom_image *images;
+
+static u64 hash_data(const u8 *data, u32 size) {
+    u64 hash = HASH_INIT;
+
+    for (u32 i=0; i<size; i++) {
+        hash = (hash ^ data[i]) * HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static u64 image_hash(rom_image *rom) {
+    if (!rom->hashed) {
+        rom->hash = hash_data(rom->data, rom->size);
+        rom->hashed = true;
+    }
+
+    return rom->hash;
+}
+
+static void image_free(rom_image *rom) {
+    if (rom->mapped) {
+        munmap((void *)rom->data, rom->size);
+    } else {
+        free((void *)rom->data);
+    }
+
+    free(rom);
+}
+
+//an image with the same content as rom, call with the lock held.
+static rom_image *find_same(rom_image *rom) {
+    for (rom_image *it = images; it; it = it->next) {
+        if (it->size == rom->size && image_hash(it) == image_hash(rom) &&
+            !memcmp(it->data, rom->data, rom->size)) {
+            return it;
+        }
+    }
+
+    return NULL;
+}
+
+//shares an existing copy of rom if there is one, call with the lock held.
+static rom_image *add_image(rom_image *rom) {
+    rom_image *same = find_same(rom);
+
+    if (same) {
+        same->refs++;
+        image_free(rom);
+        return same;
+    }
+
+    rom->refs = 1;
+    rom->next = images;
+    images = rom;
+
+    return rom;
+}
+
+static bool map_file(rom_image *rom, int fd) {
+    if (rom->size >= ROM_MIN_SIZE) {
+        void *data = mmap(NULL, rom->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data != MAP_FAILED) {
+            rom->data = data;
+            rom->mapped = true;
+            return true;
+        }
+    }
+
+    //small roms are padded with zeros, the rest is read when it can't be mapped.
+    u32 size = rom->size < ROM_MIN_SIZE ? ROM_MIN_SIZE : rom->size;
+    u8 *data = calloc(1, size);
+    u32 pos = 0;
+
+    while (pos < rom->size) {
+        ssize_t n = read(fd, data + pos, rom->size - pos);
+
+        if (n <= 0) {
+            free(data);
+            return false;
+        }
+
+        pos += n;
+    }
+
+    rom->data = data;
+    rom->size = size;
+    return true;
+}
+
+rom_image *rom_open(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) || st.st_size < 0x150 || st.st_size > 0x7FFFFFFF) {
+        close(fd);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    for (rom_image *it = images; it; it = it->next) {
+        if (it->ino == (u64)st.st_ino && it->dev == (u64)st.st_dev &&
+            it->mtime == (u64)st.st_mtime && it->size >= (u32)st.st_size) {
+            it->refs++;
+            pthread_mutex_unlock(&lock);
+            close(fd);
+            return it;
+        }
+    }
+
+    rom_image *rom = calloc(1, sizeof(rom_image));
+    rom->size = st.st_size;
+    rom->dev = st.st_dev;
+    rom->ino = st.st_ino;
+    rom->mtime = st.st_mtime;
+
+    if (!map_file(rom, fd)) {
+        pthread_mutex_unlock(&lock);
+        close(fd);
+        free(rom);
+        return NULL;
+    }
+
+    close(fd);
+
+    //only hashed when another image could have the same content.
+    bool candidate = false;
+
+    for (rom_image *it = images; it && !candidate; it = it->next) {
+        candidate = it->size == rom->size;
+    }
+
+    if (candidate) {
+        rom = add_image(rom);
+    } else {
+        rom->refs = 1;
+        rom->next = images;
+        images = rom;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return rom;
+}
+
+rom_image *rom_from_memory(const void *data, u32 size) {
+    if (size < 0x150) {
+        return NULL;
+    }
+
+    u32 alloc_size = size < ROM_MIN_SIZE ? ROM_MIN_SIZE : size;
+    u64 hash = hash_data(data, size);
+
+    pthread_mutex_lock(&lock);
+
+    for (rom_image *it = images; it; it = it->next) {
+        if (it->size == alloc_size && image_hash(it) == hash &&
+            !memcmp(it->data, data, size)) {
+            it->refs++;
+            pthread_mutex_unlock(&lock);
+            return it;
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    u8 *copy = calloc(1, alloc_size);
+    memcpy(copy, data, size);
+
+    rom_image *rom = calloc(1, sizeof(rom_image));
+    rom->data = copy;
+    rom->size = alloc_size;
+    rom->hash = size == alloc_size ? hash : hash_data(copy, alloc_size);
+    rom->hashed = true;
+
+    pthread_mutex_lock(&lock);
+    rom = add_image(rom);
+    pthread_mutex_unlock(&lock);
+
+    return rom;
+}
+
+void rom_retain(rom_image *rom) {
+    pthread_mutex_lock(&lock);
+    rom->refs++;
+    pthread_mutex_unlock(&lock);
+}
+
+void rom_release(rom_image *rom) {
+    if (!rom) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    if (--rom->refs) {
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    for (rom_image **it = &images; *it; it = &(*it)->next) {
+        if (*it == rom) {
+            *it = rom->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    image_free(rom);
+}
+
+u64 rom_hash(rom_image *rom) {
+    pthread_mutex_lock(&lock);
+    u64 hash = image_hash(rom);
+    pthread_mutex_unlock(&lock);
+
+    return hash;
+}
+
+int rom_image_count() {
+    int count = 0;
+
+    pthread_mutex_lock(&lock);
+
+    for (rom_image *it = images; it; it = it->next) {
+        count++;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return count;
+}
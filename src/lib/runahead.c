@@ -0,0 +1,99 @@
+#include <runahead.h>
+#include <state.h>
+#include <cpu.h>
+#include <ppu.h>
+#include <sound.h>
+
+typedef struct {
+    int frames;
+
+    u8 *snapshot;
+    u32 snapshot_size;
+
+    //receives the snapshot's picture on restore, the shown frame stays.
+    u32 *screen;
+} runahead_context;
+
+static runahead_context ctx;
+
+void runahead_set_frames(int frames) {
+    if (frames < 0) {
+        frames = 0;
+    }
+
+    if (frames > RUNAHEAD_MAX_FRAMES) {
+        frames = RUNAHEAD_MAX_FRAMES;
+    }
+
+    ctx.frames = frames;
+
+    //committed frames are rendered again without run-ahead.
+    ppu_set_frame_render(true);
+}
+
+int runahead_get_frames() {
+    return ctx.frames;
+}
+
+static bool run_frame() {
+    u32 frame = ppu_get_context()->current_frame;
+
+    while (frame == ppu_get_context()->current_frame) {
+        if (!cpu_step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool runahead_speculate() {
+    if (!ctx.frames) {
+        return true;
+    }
+
+    ppu_context *ppu = ppu_get_context();
+
+    //the committed frames are never shown.
+    ppu_set_frame_render(false);
+
+    u32 size = state_size();
+
+    if (size != ctx.snapshot_size) {
+        ctx.snapshot = realloc(ctx.snapshot, size);
+        ctx.snapshot_size = size;
+    }
+
+    if (!ctx.screen) {
+        ctx.screen = malloc(YRES * XRES * sizeof(u32));
+    }
+
+    state_save(ctx.snapshot, size);
+
+    sound_get_context()->muted = true;
+
+    bool running = true;
+
+    for (int i=1; i<=ctx.frames && running; i++) {
+        ppu_set_frame_render(i == ctx.frames);
+        running = run_frame();
+    }
+
+    sound_get_context()->muted = false;
+
+    u32 *shown = ppu->video_buffer;
+    ppu->video_buffer = ctx.screen;
+    state_load(ctx.snapshot, size);
+    ppu->video_buffer = shown;
+
+    return running;
+}
+
+void runahead_free() {
+    free(ctx.snapshot);
+    free(ctx.screen);
+
+    ctx.snapshot = NULL;
+    ctx.screen = NULL;
+    ctx.snapshot_size = 0;
+}
@@ -0,0 +1,58 @@
+#include <scheduler.h>
+#include <emu.h>
+#include <serial.h>
+#include <timer.h>
+
+static void (*const handlers[SCHED_EVENTS])() = {
+    [SCHED_SERIAL] = serial_complete,
+    [SCHED_FRAME_SEQUENCER] = timer_frame_sequencer,
+};
+
+static void update_next(emu_context *emu) {
+    emu->next_event = 0;
+
+    for (int i=0; i<SCHED_EVENTS; i++) {
+        if (emu->events[i] && (!emu->next_event || emu->events[i] < emu->next_event)) {
+            emu->next_event = emu->events[i];
+        }
+    }
+}
+
+void scheduler_add(sched_event event, u32 cycles) {
+    emu_context *emu = emu_get_context();
+
+    //0 means not pending.
+    emu->events[event] = (emu->cycles + cycles) | !(emu->cycles + cycles);
+    update_next(emu);
+}
+
+void scheduler_cancel(sched_event event) {
+    emu_context *emu = emu_get_context();
+
+    emu->events[event] = 0;
+    update_next(emu);
+}
+
+u32 scheduler_remaining(sched_event event) {
+    emu_context *emu = emu_get_context();
+
+    if (!emu->events[event]) {
+        return 0;
+    }
+
+    return emu->events[event] > emu->cycles ? emu->events[event] - emu->cycles : 1;
+}
+
+void scheduler_run() {
+    emu_context *emu = emu_get_context();
+
+    for (int i=0; i<SCHED_EVENTS; i++) {
+        if (emu->events[i] && emu->events[i] <= emu->cycles) {
+            //cleared first, the handler may schedule it again.
+            emu->events[i] = 0;
+            handlers[i]();
+        }
+    }
+
+    update_next(emu);
+}
@@ -0,0 +1,94 @@
+#include <serial.h>
+#include <scheduler.h>
+#include <interrupts.h>
+#include <cart.h>
+
+static serial_context main_ctx;
+static _Thread_local serial_context *ctx = &main_ctx;
+
+serial_context *serial_get_context() {
+    return ctx;
+}
+
+void serial_set_context(serial_context *context) {
+    ctx = context;
+}
+
+u8 serial_read(u16 address) {
+    if (address == 0xFF01) {
+        return ctx->sb;
+    }
+
+    //the dmg has no fast clock, bit 1 reads as 1.
+    return ctx->sc | (cart_cgb() ? 0 : 0x02);
+}
+
+void serial_write(u16 address, u8 value) {
+    if (address == 0xFF01) {
+        ctx->sb = value;
+        return;
+    }
+
+    ctx->sc = value & (cart_cgb() ? 0x83 : 0x81);
+
+    if ((ctx->sc & 0x81) != 0x81) {
+        //stopped, or waiting for the other side's clock.
+        scheduler_cancel(SCHED_SERIAL);
+        return;
+    }
+
+    scheduler_add(SCHED_SERIAL, (ctx->sc & 0x02) ? SERIAL_FAST_CYCLES : SERIAL_CYCLES);
+}
+
+void serial_set_sink(serial_sink sink, void *user) {
+    ctx->sink = sink;
+    ctx->sink_user = user;
+}
+
+u8 serial_capture_sink(u8 out, void *user) {
+    serial_capture *capture = user;
+
+    if (capture->size < sizeof(capture->data) - 1) {
+        capture->data[capture->size++] = out;
+    }
+
+    return 0xFF;
+}
+
+void serial_complete() {
+    ctx->sb = ctx->sink ? ctx->sink(ctx->sb, ctx->sink_user) : 0xFF;
+    ctx->sc &= ~0x80;
+
+    cpu_request_interrupt(IT_SERIAL);
+}
+
+bool serial_waiting() {
+    return (ctx->sc & 0x81) == 0x80;
+}
+
+u8 serial_external(u8 in) {
+    if (!serial_waiting()) {
+        return 0xFF;
+    }
+
+    u8 out = ctx->sb;
+
+    ctx->sb = in;
+    ctx->sc &= ~0x80;
+
+    cpu_request_interrupt(IT_SERIAL);
+
+    return out;
+}
+
+u32 serial_remaining() {
+    return scheduler_remaining(SCHED_SERIAL);
+}
+
+void serial_restore(u32 cycles) {
+    if (cycles && (ctx->sc & 0x81) == 0x81) {
+        scheduler_add(SCHED_SERIAL, cycles);
+    } else {
+        scheduler_cancel(SCHED_SERIAL);
+    }
+}
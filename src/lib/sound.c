@@ -1,192 +1,548 @@
 #include <sound.h>
 #include <gbio.h>
 #include <ram.h>
-#include <SDL2/SDL.h>
+#include <blip.h>
+#include <cart.h>
+#include <string.h>
 
-static sound_context ctx;
-SDL_AudioDeviceID device;
-int sample_rate = 48000;
+static sound_context main_ctx;
+static _Thread_local sound_context *ctx = &main_ctx;
 
-#define RATE (ctx.snd.rate)
-#define WAVE (ctx.snd.wave)
-#define S1 (ctx.snd.ch[0])
-#define S2 (ctx.snd.ch[1])
-#define S3 (ctx.snd.ch[2])
-#define S4 (ctx.snd.ch[3])
+//frames gathered before they are handed to the sink.
+#define SOUND_STAGE_FRAMES 256
+
+//the rate of sinks that leave it to the core.
+#define SOUND_DEFAULT_RATE 48000
+
+//the apu runs at half the cpu's clock, sound_tick counts in its ticks.
+#define SOUND_CLOCK (1 << 21)
+
+//the buffers' frame ends once this many ticks are in it.
+#define SOUND_FRAME_TICKS 4096
+
+//sound_tick brings the channels up to date once this many ticks gathered.
+#define SOUND_MIX_TICKS 1024
+
+//one level of one channel at full volume, four channels at level 15 and
+//volume 8 stay within the buffer's +-16384.
+#define SOUND_AMP 32
+
+//output samples the buffers hold, a frame is far less.
+#define SOUND_BLIP_SAMPLES 4096
+
+#define WAVE (ctx->snd.wave)
+#define S1 (ctx->snd.ch[0])
+#define S2 (ctx->snd.ch[1])
+#define S3 (ctx->snd.ch[2])
+#define S4 (ctx->snd.ch[3])
+
+const sound_sink sound_sink_null = { 0 };
+
+sound_context *sound_get_context() {
+    return ctx;
+}
+
+void sound_set_context(sound_context *context) {
+    ctx = context;
+}
+
+void sound_set_sink(const sound_sink *sink, void *user) {
+	ctx->sink = sink == &sound_sink_null ? NULL : sink;
+	ctx->sink_user = user;
+}
 
 int sound_init(u32 frequency, u32 frames) {
-	ctx.threaded = 0;
-    SDL_AudioSpec as = {0}, ob;
-	SDL_InitSubSystem(SDL_INIT_AUDIO);
-
-    as.freq = sample_rate;
-	as.format = AUDIO_U8;
-	as.channels = 2;
-	as.samples = sample_rate / 60;
-	as.userdata = 0;
-	int i;
-	for (i = 1; i < as.samples; i<<=1);
-	as.samples = i;
-	as.callback = ctx.threaded ? sound_fill : NULL;
-	device = SDL_OpenAudioDevice(NULL, 0, &as,
-		&ob, SDL_AUDIO_ALLOW_CHANNELS_CHANGE|SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
-
-    if (!device) {
-		fprintf(stderr, "Couldn't open audio: %s\n", SDL_GetError());
-		exit(-1);
+	u32 rate = frequency ? frequency : SOUND_DEFAULT_RATE;
+
+	if (ctx->sink && ctx->sink->open) {
+		rate = ctx->sink->open(ctx->sink_user, frequency, frames);
+
+		if (!rate) {
+			printf("No audio output, running without sound\n");
+			ctx->sink = NULL;
+			rate = SOUND_DEFAULT_RATE;
+		}
 	}
 
-	ctx.hz = ob.freq;
-	ctx.stereo = ob.channels - 1;
-	ctx.len = ob.size;
-	ctx.buf = malloc(ctx.len);
-	ctx.pos = 0;
-	ctx.tick = 0;
-	memset(ctx.buf, 0, ctx.len);
-	SDL_PauseAudioDevice(device, 0);
+	ctx->hz = rate;
+	ctx->pos = 0;
+	ctx->tick = 0;
+	ctx->time = 0;
+
+	free(ctx->samples);
+	ctx->samples = NULL;
+
+	if (ctx->sink && ctx->sink->write) {
+		ctx->samples = malloc(SOUND_STAGE_FRAMES * 2 * sizeof(s16));
+
+		for (int side=0; side<2; side++) {
+			if (!ctx->blip[side].deltas)
+				blip_init(&ctx->blip[side], SOUND_BLIP_SAMPLES);
+
+			blip_clear(&ctx->blip[side]);
+			blip_set_rates(&ctx->blip[side], SOUND_CLOCK, rate);
+			ctx->amp[side] = 0;
+		}
+	}
 
 	sound_reset();
+	return 0;
 }
 
 void sound_tick(int cpu_cycles) {
-	ctx.tick += cpu_cycles;
-}
+	ctx->tick += cpu_cycles;
 
-void sound_fill(void *userdata, unsigned char *stream, int len) {
-    memcpy(stream, ctx.buf, len);
-	ctx.sound_done = 1;
+	if (ctx->tick >= SOUND_MIX_TICKS)
+		sound_mix();
 }
 
+//the stage goes to the sink, a paused sink gets nothing.
 int sound_submit()
 {
-	int res,min;
-	if (!ctx.buf || ctx.paused) {
-		ctx.pos = 0;
+	if (!ctx->samples) {
+		ctx->pos = 0;
 		return 0;
 	}
-	
-	if(ctx.threaded) {
-		if(ctx.pos < ctx.len) return 1;
-		while(!ctx.sound_done) SDL_Delay(1);
-		ctx.sound_done = 0;
-		ctx.pos = 0;
-		return 1;
+
+	if (!ctx->paused) {
+		ctx->sink->write(ctx->sink_user, ctx->samples, ctx->pos / 2);
+	}
+
+	ctx->pos = 0;
+	return 1;
+}
+
+void sound_get_stats(audio_ring_stats *stats) {
+	memset(stats, 0, sizeof(*stats));
+
+	if (ctx->sink && ctx->sink->get_stats)
+		ctx->sink->get_stats(ctx->sink_user, stats);
+}
+
+static void envelope_init(sndchan *ch, u8 nrx2)
+{
+	ch->envol = nrx2 >> 4;
+	ch->endir = (nrx2>>3) & 1;
+	ch->endir |= ch->endir - 1;
+	ch->enlen = nrx2 & 7;
+	ch->encnt = ch->enlen;
+}
+
+//the sweep's next frequency, past 2047 the channel stops.
+static int sweep_calc()
+{
+	int f = S1.swfreq >> (R_NR10 & 7);
+
+	if (R_NR10 & 8) {
+		f = S1.swfreq - f;
+		S1.swneg = 1;
+	} else {
+		f = S1.swfreq + f;
 	}
 
-	min = ctx.len*2;
-	res = SDL_QueueAudio(device, ctx.buf, ctx.pos) == 0;
-	ctx.pos = 0;
-	while (res && SDL_GetQueuedAudioSize(device) > min)
-		SDL_Delay(1);
-	return res;
+	if (f > 2047) S1.on = 0;
+	return f;
 }
 
+//a channel whose dac is off doesn't start.
 void s1_init()
 {
-	S1.swcnt = 0;
-	S1.swfreq = ((R_NR14&7)<<8) + R_NR13;
-	S1.envol = R_NR12 >> 4;
-	S1.endir = (R_NR12>>3) & 1;
-	S1.endir |= S1.endir - 1;
-	S1.enlen = (R_NR12 & 7) << 15;
+	envelope_init(&S1, R_NR12);
 	if (!S1.on) S1.pos = 0;
-	S1.on = 1;
-	S1.cnt = 0;
-	S1.encnt = 0;
+	S1.on = (R_NR12 & 0xF8) != 0;
+	S1.swfreq = ((R_NR14&7)<<8) + R_NR13;
+	S1.swcnt = S1.swlen ? S1.swlen : 8;
+	S1.swon = S1.swlen || (R_NR10 & 7);
+	S1.swneg = 0;
+	if (R_NR10 & 7) sweep_calc();
 }
 
 void s2_init()
 {
-	S2.envol = R_NR22 >> 4;
-	S2.endir = (R_NR22>>3) & 1;
-	S2.endir |= S2.endir - 1;
-	S2.enlen = (R_NR22 & 7) << 15;
+	envelope_init(&S2, R_NR22);
 	if (!S2.on) S2.pos = 0;
-	S2.on = 1;
-	S2.cnt = 0;
-	S2.encnt = 0;
+	S2.on = (R_NR22 & 0xF8) != 0;
 }
 
 void s3_init()
 {
 	int i;
 	if (!S3.on) S3.pos = 0;
-	S3.cnt = 0;
 	S3.on = R_NR30 >> 7;
 	if (S3.on) for (i = 0; i < 16; i++)
-		ctx.snd_mem[i+0x30] = 0x13 ^ ctx.snd_mem[i+0x31];
+		ctx->snd_mem[i+0x30] = 0x13 ^ ctx->snd_mem[i+0x31];
 }
 
 void s4_init()
 {
-	S4.envol = R_NR42 >> 4;
-	S4.endir = (R_NR42>>3) & 1;
-	S4.endir |= S4.endir - 1;
-	S4.enlen = (R_NR42 & 7) << 15;
-	S4.on = 1;
-	S4.pos = 0;
-	S4.cnt = 0;
-	S4.encnt = 0;
+	envelope_init(&S4, R_NR42);
+	S4.on = (R_NR42 & 0xF8) != 0;
+	S4.pos = 0x7FFF;
 }
 
-u8 sound_read(u16 address) {
+//a write of NRx4, before its trigger. Enabled while the next step doesn't
+//count, the length counts once more. A trigger restarts a finished length.
+static void length_write(sndchan *ch, u8 nrx4, u8 b, int max)
+{
+	int odd = (ctx->snd.seq & 1) && (b & 64);
+
+	if (odd && !(nrx4 & 64) && ch->len && !--ch->len && !(b & 128))
+		ch->on = 0;
+
+	if ((b & 128) && !ch->len)
+		ch->len = odd ? max - 1 : max;
+}
+
+//output goes to the buffers while the apu is heard, run-ahead mutes it.
+static bool output() {
+	return ctx->samples && !ctx->muted;
+}
+
+//the mixer, the changes of each side's sum are added to its buffer.
+static void mix_out(u32 time) {
+	int l = 0, r = 0;
+
+	if (!output()) return;
+
+	for (int i = 0; i < 4; i++) {
+		if (R_NR51 & (0x10 << i)) l += ctx->snd.ch[i].level;
+		if (R_NR51 & (0x01 << i)) r += ctx->snd.ch[i].level;
+	}
+
+	l *= (((R_NR50 >> 4) & 7) + 1) * SOUND_AMP;
+	r *= ((R_NR50 & 7) + 1) * SOUND_AMP;
+
+	if (l != ctx->amp[0]) {
+		blip_add_delta(&ctx->blip[0], time, l - ctx->amp[0]);
+		ctx->amp[0] = l;
+	}
+
+	if (r != ctx->amp[1]) {
+		blip_add_delta(&ctx->blip[1], time, r - ctx->amp[1]);
+		ctx->amp[1] = r;
+	}
+}
+
+//one channel's change goes to the sides it is panned to, mix_out has
+//already brought the sums up to date.
+static void set_level(sndchan *ch, int level, u32 time) {
+	int i = ch - ctx->snd.ch;
+	int delta = level - ch->level;
+
+	if (!delta) return;
+	ch->level = level;
+
+	if (!output()) return;
+
+	if (R_NR51 & (0x10 << i)) {
+		int d = delta * (((R_NR50 >> 4) & 7) + 1) * SOUND_AMP;
+		blip_add_delta(&ctx->blip[0], time, d);
+		ctx->amp[0] += d;
+	}
+
+	if (R_NR51 & (0x01 << i)) {
+		int d = delta * ((R_NR50 & 7) + 1) * SOUND_AMP;
+		blip_add_delta(&ctx->blip[1], time, d);
+		ctx->amp[1] += d;
+	}
+}
+
+//the silent channels only move their position.
+static u32 skip_steps(sndchan *ch, u32 t, u32 to, int mask) {
+	if (t <= to) {
+		u32 n = (to - t) / ch->freq + 1;
+		ch->pos = (ch->pos + n) & mask;
+		t += n * ch->freq;
+	}
+
+	return t;
+}
+
+static const u8 duty[4] = { 0x01, 0x81, 0x87, 0x7E };
+
+//the waveforms step from one edge to the next, the work is per edge and
+//not per output sample. Steps at exactly to are taken. Unheard they jump
+//to the last step, the level it leaves is the same.
+static void run_square(sndchan *ch, u8 nrx1, u32 from, u32 to) {
+	u8 pattern = duty[nrx1 >> 6];
+	u32 t = from + ch->delay;
+
+	//the periods are set by sound_reset, a machine without sound has none.
+	if (!ch->freq) return;
+
+	ch->pos &= 7;
+
+	if (!ch->on || !ch->envol) {
+		set_level(ch, 0, from);
+		t = skip_steps(ch, t, to, 7);
+	} else if (!output()) {
+		t = skip_steps(ch, t, to, 7);
+		ch->level = (pattern >> ch->pos) & 1 ? ch->envol : 0;
+	} else {
+		set_level(ch, (pattern >> ch->pos) & 1 ? ch->envol : 0, from);
+
+		for (; t <= to; t += ch->freq) {
+			ch->pos = (ch->pos + 1) & 7;
+			set_level(ch, (pattern >> ch->pos) & 1 ? ch->envol : 0, t);
+		}
+	}
+
+	ch->delay = t - to;
+}
+
+static int wave_sample(int pos) {
+	return (WAVE[pos >> 1] >> (pos & 1 ? 0 : 4)) & 15;
+}
+
+static void run_wave(u32 from, u32 to) {
+	int shift = (R_NR32 >> 5) & 3;
+	u32 t = from + S3.delay;
+
+	if (!S3.freq) return;
+
+	S3.pos &= 31;
+
+	if (!S3.on || !shift) {
+		set_level(&S3, 0, from);
+		t = skip_steps(&S3, t, to, 31);
+	} else if (!output()) {
+		t = skip_steps(&S3, t, to, 31);
+		S3.level = wave_sample(S3.pos) >> (shift - 1);
+	} else {
+		shift--;
+		set_level(&S3, wave_sample(S3.pos) >> shift, from);
+
+		for (; t <= to; t += S3.freq) {
+			S3.pos = (S3.pos + 1) & 31;
+			set_level(&S3, wave_sample(S3.pos) >> shift, t);
+		}
+	}
+
+	S3.delay = t - to;
+}
+
+//the lfsr is in pos, its low bit clear is a high output.
+static void run_noise(u32 from, u32 to) {
+	bool audible = S4.on && S4.envol;
+	bool heard = audible && output();
+	u32 t = from + S4.delay;
+
+	set_level(&S4, audible && !(S4.pos & 1) ? S4.envol : 0, from);
+
+	//shifts of 14 and 15 don't clock it.
+	if (!S4.freq) return;
+
+	//the trigger starts it over, while off it doesn't matter.
+	if (!S4.on) {
+		S4.delay = skip_steps(&S4, t, to, 0x7FFF) - to;
+		return;
+	}
+
+	for (; t <= to; t += S4.freq) {
+		unsigned bit = (S4.pos ^ (S4.pos >> 1)) & 1;
+		S4.pos = (S4.pos >> 1) | (bit << 14);
+		if (R_NR43 & 8) S4.pos = (S4.pos & ~0x40) | (bit << 6);
+		if (heard) set_level(&S4, S4.pos & 1 ? 0 : S4.envol, t);
+	}
+
+	if (!heard) S4.level = audible && !(S4.pos & 1) ? S4.envol : 0;
+	S4.delay = t - to;
+}
+
+static void step_length(sndchan *ch, u8 nrx4) {
+	if ((nrx4 & 64) && ch->len && !--ch->len)
+		ch->on = 0;
+}
+
+//a period of 0 stops the envelope.
+static void step_envelope(sndchan *ch) {
+	if (!ch->enlen || --ch->encnt > 0)
+		return;
+
+	ch->encnt = ch->enlen;
+
+	if (ch->envol + ch->endir >= 0 && ch->envol + ch->endir <= 15)
+		ch->envol += ch->endir;
+}
+
+//the timer counts a period of 0 as 8, but then the frequency stays.
+static void step_sweep() {
+	int f;
+
+	if (--S1.swcnt > 0)
+		return;
+
+	S1.swcnt = S1.swlen ? S1.swlen : 8;
+
+	if (!S1.swon || !S1.swlen)
+		return;
+
+	f = sweep_calc();
+
+	if (f <= 2047 && (R_NR10 & 7))
+	{
+		S1.swfreq = f;
+		R_NR13 = f;
+		R_NR14 = (R_NR14 & 0xF8) | (f>>8);
+		s1_freq();
+
+		//the new frequency is checked right away, it isn't kept.
+		sweep_calc();
+	}
+}
+
+void sound_frame_sequencer() {
+	int step = ctx->snd.seq;
+
+	if (!(R_NR52 & 128)) return;
+
+	//the channels run up to the step with the counters before it.
 	sound_mix();
-    return ctx.snd_mem[address-0xFF00];
+	ctx->snd.seq = (step + 1) & 7;
+
+	if (!(step & 1))
+	{
+		step_length(&S1, R_NR14);
+		step_length(&S2, R_NR24);
+		step_length(&S3, R_NR34);
+		step_length(&S4, R_NR44);
+	}
+
+	if (step == 2 || step == 6)
+		step_sweep();
+
+	if (step == 7)
+	{
+		step_envelope(&S1);
+		step_envelope(&S2);
+		step_envelope(&S4);
+	}
+}
+
+//the samples finished so far go to the sink, the buffers' next frame starts now.
+static void end_frame() {
+	u32 avail;
+
+	if (!output()) return;
+
+	blip_end_frame(&ctx->blip[0], ctx->time);
+	avail = blip_end_frame(&ctx->blip[1], ctx->time);
+	ctx->time = 0;
+
+	while (avail) {
+		u32 n = SOUND_STAGE_FRAMES - ctx->pos / 2;
+		if (n > avail) n = avail;
+
+		blip_read_s16(&ctx->blip[0], ctx->samples + ctx->pos, n, 2);
+		blip_read_s16(&ctx->blip[1], ctx->samples + ctx->pos + 1, n, 2);
+		ctx->pos += n * 2;
+		avail -= n;
+
+		if (ctx->pos >= SOUND_STAGE_FRAMES * 2)
+			sound_submit();
+	}
+}
+
+//runs the channels for the gathered ticks. While muted the buffers' time
+//stands still, the muted time is taken back by run-ahead anyway.
+void sound_mix() {
+	u32 from = ctx->time;
+	u32 to = from + ctx->tick;
+
+	//the levels changed unheard while muted.
+	mix_out(from);
+
+	if (!ctx->tick) return;
+
+	run_square(&S1, R_NR11, from, to);
+	run_square(&S2, R_NR21, from, to);
+	run_wave(from, to);
+	run_noise(from, to);
+
+	ctx->tick = 0;
+
+	if (output()) ctx->time = to;
+	if (ctx->time >= SOUND_FRAME_TICKS) end_frame();
+}
+
+//the status bits of NR52 are the channels', the counters that clear them
+//only run in the sequencer and on writes.
+u8 sound_read(u16 address) {
+	if (address - 0xFF00 == RI_NR52)
+		return (R_NR52 & 128) | S1.on | (S2.on<<1) | (S3.on<<2) | (S4.on<<3);
+
+    return ctx->snd_mem[address-0xFF00];
+}
+
+//writing the volume as it is, the envelope starts over from it.
+static void envelope_write(sndchan *ch, u8 b)
+{
+	envelope_init(ch, b);
+	if (!(b & 0xF8)) ch->on = 0;
 }
 
 void sound_write(u16 address, u8 b) {
-	if (!(R_NR52 & 128) && (address - 0xFF00) != RI_NR52) return;
 	if (((address - 0xFF00) & 0xF0) == 0x30)
 	{
 		if (S3.on) sound_mix();
 		if (!S3.on)
-			WAVE[address - 0xFF00 -0x30] = ctx.snd_mem[address- 0xFF00] = b;
+			WAVE[address - 0xFF00 -0x30] = ctx->snd_mem[address- 0xFF00] = b;
+		return;
+	}
+	if (!(R_NR52 & 128) && (address - 0xFF00) != RI_NR52)
+	{
+		//while off only the dmg's length counters can be loaded.
+		if (cart_cgb()) return;
+		switch (address-0xFF00)
+		{
+		case RI_NR11: S1.len = 64-(b&63); break;
+		case RI_NR21: S2.len = 64-(b&63); break;
+		case RI_NR31: S3.len = 256-b; break;
+		case RI_NR41: S4.len = 64-(b&63); break;
+		}
 		return;
 	}
 	sound_mix();
 	switch (address-0xFF00)
 	{
 	case RI_NR10:
+		//leaving negate after subtracting stops the channel.
+		if (S1.swneg && !(b & 8)) S1.on = 0;
 		R_NR10 = b;
-		S1.swlen = ((R_NR10>>4) & 7) << 14;
-		S1.swfreq = ((R_NR14&7)<<8) + R_NR13;
+		S1.swlen = (R_NR10>>4) & 7;
 		break;
 	case RI_NR11:
 		R_NR11 = b;
-		S1.len = (64-(R_NR11&63)) << 13;
+		S1.len = 64-(R_NR11&63);
 		break;
 	case RI_NR12:
 		R_NR12 = b;
-		S1.envol = R_NR12 >> 4;
-		S1.endir = (R_NR12>>3) & 1;
-		S1.endir |= S1.endir - 1;
-		S1.enlen = (R_NR12 & 7) << 15;
+		envelope_write(&S1, b);
 		break;
 	case RI_NR13:
 		R_NR13 = b;
 		s1_freq();
 		break;
 	case RI_NR14:
+		length_write(&S1, R_NR14, b, 64);
 		R_NR14 = b;
 		s1_freq();
 		if (b & 128) s1_init();
 		break;
 	case RI_NR21:
 		R_NR21 = b;
-		S2.len = (64-(R_NR21&63)) << 13;
+		S2.len = 64-(R_NR21&63);
 		break;
 	case RI_NR22:
 		R_NR22 = b;
-		S2.envol = R_NR22 >> 4;
-		S2.endir = (R_NR22>>3) & 1;
-		S2.endir |= S2.endir - 1;
-		S2.enlen = (R_NR22 & 7) << 15;
+		envelope_write(&S2, b);
 		break;
 	case RI_NR23:
 		R_NR23 = b;
 		s2_freq();
 		break;
 	case RI_NR24:
+		length_write(&S2, R_NR24, b, 64);
 		R_NR24 = b;
 		s2_freq();
 		if (b & 128) s2_init();
@@ -197,7 +553,7 @@ void sound_write(u16 address, u8 b) {
 		break;
 	case RI_NR31:
 		R_NR31 = b;
-		S3.len = (256-R_NR31) << 13;
+		S3.len = 256-R_NR31;
 		break;
 	case RI_NR32:
 		R_NR32 = b;
@@ -207,199 +563,103 @@ void sound_write(u16 address, u8 b) {
 		s3_freq();
 		break;
 	case RI_NR34:
+		length_write(&S3, R_NR34, b, 256);
 		R_NR34 = b;
 		s3_freq();
 		if (b & 128) s3_init();
 		break;
 	case RI_NR41:
 		R_NR41 = b;
-		S4.len = (64-(R_NR41&63)) << 13;
+		S4.len = 64-(R_NR41&63);
 		break;
 	case RI_NR42:
 		R_NR42 = b;
-		S4.envol = R_NR42 >> 4;
-		S4.endir = (R_NR42>>3) & 1;
-		S4.endir |= S4.endir - 1;
-		S4.enlen = (R_NR42 & 7) << 15;
+		envelope_write(&S4, b);
 		break;
 	case RI_NR43:
 		R_NR43 = b;
 		s4_freq();
 		break;
 	case RI_NR44:
+		length_write(&S4, R_NR44, b, 64);
 		R_NR44 = b;
 		if (b & 128) s4_init();
 		break;
 	case RI_NR50:
 		R_NR50 = b;
+		mix_out(ctx->time);
 		break;
 	case RI_NR51:
 		R_NR51 = b;
+		mix_out(ctx->time);
 		break;
 	case RI_NR52:
-		R_NR52 = b;
-		if (!(R_NR52 & 128))
+		//powered on, the sequencer's next step is the first.
+		if ((b & 128) && !(R_NR52 & 128))
+			ctx->snd.seq = 0;
+		if (!(b & 128) && (R_NR52 & 128))
 			sound_off();
+		R_NR52 = b & 128;
 		break;
 	default:
 		return;
 	}
 }
 
-void sound_mix() {
-	int s, l, r, f, n;
-
-	if (!RATE || ctx.tick < RATE) return;
-	for (; ctx.tick >= RATE; ctx.tick -= RATE)
-	{
-		l = r = 0;
-
-		if (S1.on)
-		{
-			s = sqwave[R_NR11>>6][(S1.pos>>18)&7] & S1.envol;
-			S1.pos += S1.freq;
-			if ((R_NR14 & 64) && ((S1.cnt += RATE) >= S1.len))
-				S1.on = 0;
-			if (S1.enlen && (S1.encnt += RATE) >= S1.enlen)
-			{
-				S1.encnt -= S1.enlen;
-				S1.envol += S1.endir;
-				if (S1.envol < 0) S1.envol = 0;
-				if (S1.envol > 15) S1.envol = 15;
-			}
-			if (S1.swlen && (S1.swcnt += RATE) >= S1.swlen)
-			{
-				S1.swcnt -= S1.swlen;
-				f = S1.swfreq;
-				n = (R_NR10 & 7);
-				if (R_NR10 & 8) f -= (f >> n);
-				else f += (f >> n);
-				if (f > 2047)
-					S1.on = 0;
-				else
-				{
-					S1.swfreq = f;
-					R_NR13 = f;
-					R_NR14 = (R_NR14 & 0xF8) | (f>>8);
-					s1_freq_d(2048 - f);
-				}
-			}
-			s <<= 2;
-			if (R_NR51 & 0x01) r += s;
-			if (R_NR51 & 0x10) l += s;
-		}
-		
-		if (S2.on)
-		{
-			s = sqwave[R_NR21>>6][(S2.pos>>18)&7] & S2.envol;
-			S2.pos += S2.freq;
-			if ((R_NR24 & 64) && ((S2.cnt += RATE) >= S2.len))
-				S2.on = 0;
-			if (S2.enlen && (S2.encnt += RATE) >= S2.enlen)
-			{
-				S2.encnt -= S2.enlen;
-				S2.envol += S2.endir;
-				if (S2.envol < 0) S2.envol = 0;
-				if (S2.envol > 15) S2.envol = 15;
-			}
-			s <<= 2;
-			if (R_NR51 & 0x02) r += s;
-			if (R_NR51 & 0x20) l += s;
-		}
-		
-		if (S3.on)
-		{
-			s = WAVE[(S3.pos>>22) & 15];
-			if (S3.pos & (1<<21)) s &= 15;
-			else s >>= 4;
-			s -= 8;
-			S3.pos += S3.freq;
-			if ((R_NR34 & 64) && ((S3.cnt += RATE) >= S3.len))
-				S3.on = 0;
-			if (R_NR32 & 96) s <<= (3 - ((R_NR32>>5)&3));
-			else s = 0;
-			if (R_NR51 & 0x04) r += s;
-			if (R_NR51 & 0x40) l += s;
-		}
-
-		if (S4.on)
-		{
-			if (R_NR43 & 8) s = 1 & (noise7[
-				(S4.pos>>20)&15] >> (7-((S4.pos>>17)&7)));
-			else s = 1 & (noise15[
-				(S4.pos>>20)&4095] >> (7-((S4.pos>>17)&7)));
-			s = (-s) & S4.envol;
-			S4.pos += S4.freq;
-			if ((R_NR44 & 64) && ((S4.cnt += RATE) >= S4.len))
-				S4.on = 0;
-			if (S4.enlen && (S4.encnt += RATE) >= S4.enlen)
-			{
-				S4.encnt -= S4.enlen;
-				S4.envol += S4.endir;
-				if (S4.envol < 0) S4.envol = 0;
-				if (S4.envol > 15) S4.envol = 15;
-			}
-			s += s << 1;
-			if (R_NR51 & 0x08) r += s;
-			if (R_NR51 & 0x80) l += s;
-		}
-		
-		l *= (R_NR50 & 0x07);
-		r *= ((R_NR50 & 0x70)>>4);
-		l >>= 4;
-		r >>= 4;
-		
-		if (l > 127) l = 127;
-		else if (l < -128) l = -128;
-		if (r > 127) r = 127;
-		else if (r < -128) r = -128;
-
-		if (ctx.buf)
-		{
-			if (ctx.pos >= ctx.len)
-				sound_submit();
-			if (ctx.stereo)
-			{
-				ctx.buf[ctx.pos++] = l+128;
-				ctx.buf[ctx.pos++] = r+128;
-			}
-			else ctx.buf[ctx.pos++] = ((l+r)>>1)+128;
-		}
-	}
-	R_NR52 = (R_NR52&0xF0) | S1.on | (S2.on<<1) | (S3.on<<2) | (S4.on<<3);
-}
+//the sink is closed, the machine goes on without output.
+void sound_close() {
+	if (ctx->samples && ctx->pos)
+		sound_submit();
 
-void sound_cleanup() {
-	SDL_CloseAudio();
-}
+	if (ctx->sink && ctx->sink->close)
+		ctx->sink->close(ctx->sink_user);
 
-void sound_close() {
-	SDL_CloseAudioDevice(device);
+	ctx->sink = NULL;
+	free(ctx->samples);
+	ctx->samples = NULL;
 }
 
 void sound_pause(int dopause) {
-	ctx.paused = dopause;
-	SDL_PauseAudioDevice(device, ctx.paused);
+	ctx->paused = dopause;
+
+	if (ctx->sink && ctx->sink->pause)
+		ctx->sink->pause(ctx->sink_user, dopause);
 }
 
+//the registers as the boot rom leaves them.
 void sound_reset() {
-	memset(&ctx.snd, 0, sizeof ctx.snd);
-	if (ctx.hz) {
-		ctx.snd.rate = (1<<21) / ctx.hz;
-	} else {
-		ctx.snd.rate = 0;
-	}
+	memset(&ctx->snd, 0, sizeof ctx->snd);
+	memcpy(ctx->snd.wave, dmgwave, 16);
+	memcpy(&ctx->snd_mem[0x30], ctx->snd.wave, 16);
+	R_NR10 = 0x80;
+	R_NR11 = 0xBF;
+	R_NR12 = 0xF3;
+	R_NR14 = 0xBF;
+	R_NR21 = 0x3F;
+	R_NR22 = 0x00;
+	R_NR24 = 0xBF;
+	R_NR30 = 0x7F;
+	R_NR31 = 0xFF;
+	R_NR32 = 0x9F;
+	R_NR34 = 0xBF;
+	R_NR41 = 0xFF;
+	R_NR42 = 0x00;
+	R_NR43 = 0x00;
+	R_NR44 = 0xBF;
+	R_NR50 = 0x77;
+	R_NR51 = 0xF3;
+	R_NR52 = 0x80;
 
-	memcpy(ctx.snd.wave, dmgwave, 16);
-	memcpy(&ctx.snd_mem[0x30], ctx.snd.wave, 16);
-	sound_off();
-	R_NR52 = 0xF1;
+	sound_dirty();
+	mix_out(ctx->time);
 }
 
+//the periods in ticks, of a duty step, a wave sample and a noise shift.
+static const int noise_divisor[8] = { 4, 8, 16, 24, 32, 40, 48, 56 };
+
 void s1_freq_d(int d)
 {
-	if (ctx.snd.rate > (d<<4)) ctx.snd.ch[0].freq = 0;
-	else ctx.snd.ch[1].freq = (ctx.snd.rate << 17)/d;
+	S1.freq = d << 1;
 }
 
 void s1_freq()
@@ -409,73 +669,43 @@ void s1_freq()
 
 void s2_freq()
 {
-	int d = 2048 - (((R_NR24&7)<<8) + R_NR23);
-	if (ctx.snd.rate > (d<<4)) ctx.snd.ch[1].freq = 0;
-	else ctx.snd.ch[1].freq = (ctx.snd.rate << 17)/d;
+	S2.freq = (2048 - (((R_NR24&7)<<8) + R_NR23)) << 1;
 }
 
 void s3_freq()
 {
-	int d = 2048 - (((R_NR34&7)<<8) + R_NR33);
-	if (ctx.snd.rate > (d<<3)) ctx.snd.ch[2].freq = 0;
-	else ctx.snd.ch[2].freq = (ctx.snd.rate << 21)/d;
+	S3.freq = 2048 - (((R_NR34&7)<<8) + R_NR33);
 }
 
 void s4_freq()
 {
-	ctx.snd.ch[3].freq = (freqtab[R_NR43&7] >> (R_NR43 >> 4)) * ctx.snd.rate;
-	if (ctx.snd.ch[3].freq >> 18) ctx.snd.ch[3].freq = 1<<18;
+	int shift = R_NR43 >> 4;
+	S4.freq = shift >= 14 ? 0 : noise_divisor[R_NR43&7] << shift;
 }
 
+//what the channels keep of their registers.
 void sound_dirty()
 {
-	S1.swlen = ((R_NR10>>4) & 7) << 14;
-	S1.len = (64-(R_NR11&63)) << 13;
-	S1.envol = R_NR12 >> 4;
-	S1.endir = (R_NR12>>3) & 1;
-	S1.endir |= S1.endir - 1;
-	S1.enlen = (R_NR12 & 7) << 15;
+	S1.swlen = (R_NR10>>4) & 7;
+	envelope_init(&S1, R_NR12);
 	s1_freq();
-	S2.len = (64-(R_NR21&63)) << 13;
-	S2.envol = R_NR22 >> 4;
-	S2.endir = (R_NR22>>3) & 1;
-	S2.endir |= S2.endir - 1;
-	S2.enlen = (R_NR22 & 7) << 15;
+	envelope_init(&S2, R_NR22);
 	s2_freq();
-	S3.len = (256-R_NR31) << 20;
 	s3_freq();
-	S4.len = (64-(R_NR41&63)) << 13;
-	S4.envol = R_NR42 >> 4;
-	S4.endir = (R_NR42>>3) & 1;
-	S4.endir |= S4.endir - 1;
-	S4.enlen = (R_NR42 & 7) << 15;
+	envelope_init(&S4, R_NR42);
 	s4_freq();
 }
 
+//powered off, the registers are cleared and the channels stop. The dmg
+//keeps its length counters.
 void sound_off() {
-	memset(&ctx.snd.ch[0], 0, sizeof ctx.snd.ch[0]);
-	memset(&ctx.snd.ch[1], 0, sizeof ctx.snd.ch[1]);
-	memset(&ctx.snd.ch[2], 0, sizeof ctx.snd.ch[2]);
-	memset(&ctx.snd.ch[3], 0, sizeof ctx.snd.ch[3]);
-	R_NR10 = 0x80;
-	R_NR11 = 0xBF;
-	R_NR12 = 0xF3;
-	R_NR14 = 0xBF;
-	R_NR21 = 0x3F;
-	R_NR22 = 0x00;
-	R_NR24 = 0xBF;
-	R_NR30 = 0x7F;
-	R_NR31 = 0xFF;
-	R_NR32 = 0x9F;
-	R_NR34 = 0xBF;
-	R_NR41 = 0xFF;
-	R_NR42 = 0x00;
-	R_NR43 = 0x00;
-	R_NR44 = 0xBF;
-	R_NR50 = 0x77;
-	R_NR51 = 0xF3;
-	R_NR52 = 0x70;
+	for (int i = 0; i < 4; i++) {
+		int len = ctx->snd.ch[i].len;
+		memset(&ctx->snd.ch[i], 0, sizeof ctx->snd.ch[i]);
+		if (!cart_cgb()) ctx->snd.ch[i].len = len;
+	}
+	memset(&ctx->snd_mem[RI_NR10], 0, RI_NR52 - RI_NR10);
 
 	sound_dirty();
+	mix_out(ctx->time);
 }
-
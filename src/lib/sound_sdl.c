@@ -0,0 +1,73 @@
+#include <sound.h>
+#include <SDL2/SDL.h>
+
+static SDL_AudioDeviceID device;
+int sample_rate = 48000;
+
+//the emulation thread only writes it, the audio callback only reads it.
+static audio_ring ring;
+
+//on the audio thread.
+static void sdl_fill(void *userdata, unsigned char *stream, int len) {
+	audio_ring_read(userdata, (s16 *)stream, len / (2 * sizeof(s16)));
+}
+
+static u32 sdl_open(void *user, u32 frequency, u32 frames) {
+	SDL_AudioSpec as = {0}, ob;
+	SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+	//the core resamples to any rate, sdl gets exactly what it asked for.
+	as.freq = frequency ? (int)frequency : sample_rate;
+	as.format = AUDIO_S16SYS;
+	as.channels = 2;
+	as.samples = as.freq / 60;
+	int i;
+	for (i = 1; i < as.samples; i<<=1);
+	as.samples = i;
+	as.callback = sdl_fill;
+	as.userdata = &ring;
+	device = SDL_OpenAudioDevice(NULL, 0, &as, &ob, 0);
+
+	if (!device) {
+		fprintf(stderr, "Couldn't open audio: %s\n", SDL_GetError());
+		return 0;
+	}
+
+	//four callbacks deep, the first one finds one callback of silence.
+	if (!audio_ring_init(&ring, ob.samples * 4)) {
+		fprintf(stderr, "Couldn't allocate the audio ring\n");
+		SDL_CloseAudioDevice(device);
+		device = 0;
+		return 0;
+	}
+
+	s16 *silence = calloc(ob.samples * 2, sizeof(s16));
+	if (silence) audio_ring_write(&ring, silence, ob.samples);
+	free(silence);
+
+	SDL_PauseAudioDevice(device, 0);
+	return ob.freq;
+}
+
+//never waits, what doesn't fit in the ring is dropped and counted.
+static void sdl_write(void *user, const s16 *samples, u32 frames) {
+	audio_ring_write(&ring, samples, frames);
+}
+
+static void sdl_pause(void *user, bool paused) {
+	SDL_PauseAudioDevice(device, paused);
+}
+
+static void sdl_close(void *user) {
+	SDL_CloseAudioDevice(device);
+	audio_ring_free(&ring);
+	device = 0;
+}
+
+static void sdl_get_stats(void *user, audio_ring_stats *stats) {
+	audio_ring_get_stats(&ring, stats);
+}
+
+const sound_sink sound_sink_sdl = {
+	sdl_open, sdl_write, sdl_pause, sdl_close, sdl_get_stats
+};
@@ -0,0 +1,83 @@
+#include <sound.h>
+#include <string.h>
+
+#define WAV_HEADER_SIZE 44
+
+static void put_le(u8 *p, u32 value, int bytes) {
+	for (int i=0; i<bytes; i++) {
+		p[i] = value >> (i * 8);
+	}
+}
+
+//the sizes are only known on close, until then they say empty.
+static void write_header(sound_wav *wav) {
+	u8 h[WAV_HEADER_SIZE];
+	u32 data = wav->frames * 4;
+
+	memcpy(h, "RIFF", 4);
+	put_le(h + 4, 36 + data, 4);
+	memcpy(h + 8, "WAVEfmt ", 8);
+	put_le(h + 16, 16, 4);
+	put_le(h + 20, 1, 2); //pcm
+	put_le(h + 22, 2, 2);
+	put_le(h + 24, wav->rate, 4);
+	put_le(h + 28, wav->rate * 4, 4);
+	put_le(h + 32, 4, 2);
+	put_le(h + 34, 16, 2);
+	memcpy(h + 36, "data", 4);
+	put_le(h + 40, data, 4);
+
+	fseek(wav->fp, 0, SEEK_SET);
+	fwrite(h, 1, WAV_HEADER_SIZE, wav->fp);
+}
+
+static u32 wav_open(void *user, u32 frequency, u32 frames) {
+	sound_wav *wav = user;
+
+	wav->fp = fopen(wav->path, "wb");
+	wav->rate = frequency ? frequency : 48000;
+	wav->frames = 0;
+
+	if (!wav->fp) {
+		printf("Failed to open %s\n", wav->path);
+		return 0;
+	}
+
+	write_header(wav);
+	return wav->rate;
+}
+
+static void wav_write(void *user, const s16 *samples, u32 frames) {
+	sound_wav *wav = user;
+	u8 bytes[512 * 4];
+
+	//little endian whatever the host.
+	while (frames) {
+		u32 n = frames < 512 ? frames : 512;
+
+		for (u32 i=0; i<n * 2; i++) {
+			put_le(bytes + i * 2, (u16)samples[i], 2);
+		}
+
+		fwrite(bytes, 4, n, wav->fp);
+		wav->frames += n;
+		samples += n * 2;
+		frames -= n;
+	}
+}
+
+static void wav_close(void *user) {
+	sound_wav *wav = user;
+
+	if (!wav->fp) {
+		return;
+	}
+
+	write_header(wav);
+	fclose(wav->fp);
+	wav->fp = NULL;
+}
+
+const sound_sink sound_sink_wav = {
+	wav_open, wav_write, NULL, wav_close, NULL
+};
@@ -0,0 +1,988 @@
+#include <state.h>
+#include <cpu.h>
+#include <ppu.h>
+#include <ppu_deferred.h>
+#include <lcd.h>
+#include <timer.h>
+#include <dma.h>
+#include <ram.h>
+#include <cart.h>
+#include <sound.h>
+#include <gamepad.h>
+#include <gbio.h>
+#include <serial.h>
+#include <string.h>
+
+#define STATE_HEADER_SIZE 20
+#define SECTION_HEADER_SIZE 8
+#define NO_INDEX 0xFF
+
+#define SECTION_ID(a, b, c, d) \
+    ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+//without data the writer only counts, so sizing and saving share the code.
+//a hashing writer folds the bytes into hash instead.
+typedef struct {
+    u8 *data;
+    u32 size;
+    u32 pos;
+    bool hashing;
+    u64 hash;
+} state_writer;
+
+//reads past the end of a section return zeros.
+typedef struct {
+    const u8 *data;
+    u32 size;
+    u32 pos;
+} state_reader;
+
+typedef struct {
+    u32 id;
+    void (*save)(state_writer *w);
+    void (*load)(state_reader *r);
+} state_section;
+
+static void put_bytes(state_writer *w, const void *src, u32 len) {
+    if (w->hashing) {
+        for (u32 i=0; i<len; i++) {
+            w->hash = (w->hash ^ ((const u8 *)src)[i]) * 0x100000001B3ULL;
+        }
+    } else if (w->data && w->pos + len <= w->size) {
+        memcpy(w->data + w->pos, src, len);
+    }
+
+    w->pos += len;
+}
+
+static void put_u8(state_writer *w, u8 value) {
+    put_bytes(w, &value, 1);
+}
+
+static void put_u16(state_writer *w, u16 value) {
+    u8 b[2] = { value & 0xFF, value >> 8 };
+    put_bytes(w, b, 2);
+}
+
+static void put_u32(state_writer *w, u32 value) {
+    u8 b[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+    put_bytes(w, b, 4);
+}
+
+static void put_u32_array(state_writer *w, const u32 *values, u32 count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    put_bytes(w, values, count * 4);
+#else
+    for (u32 i=0; i<count; i++) {
+        put_u32(w, values[i]);
+    }
+#endif
+}
+
+static void get_bytes(state_reader *r, void *dst, u32 len) {
+    u32 avail = r->pos < r->size ? r->size - r->pos : 0;
+    u32 n = len < avail ? len : avail;
+
+    memcpy(dst, r->data + r->pos, n);
+    memset((u8 *)dst + n, 0, len - n);
+    r->pos += len;
+}
+
+//paged memory is stored as plain bytes, missing pages as zeros.
+static void put_pages(state_writer *w, mem_page **pages, u32 len) {
+    static const u8 zeros[PAGE_SIZE];
+
+    for (u32 offset=0; offset<len; offset += PAGE_SIZE) {
+        mem_page *page = pages[offset >> PAGE_SHIFT];
+        put_bytes(w, page ? page->data : zeros, PAGE_SIZE);
+    }
+}
+
+static void get_pages(state_reader *r, mem_page **pages, u32 len) {
+    u8 data[PAGE_SIZE];
+
+    for (u32 offset=0; offset<len; offset += PAGE_SIZE) {
+        if (r->pos + PAGE_SIZE <= r->size) {
+            page_write(pages, offset, r->data + r->pos, PAGE_SIZE);
+            r->pos += PAGE_SIZE;
+        } else {
+            get_bytes(r, data, PAGE_SIZE);
+            page_write(pages, offset, data, PAGE_SIZE);
+        }
+    }
+}
+
+static u8 get_u8(state_reader *r) {
+    u8 value;
+    get_bytes(r, &value, 1);
+    return value;
+}
+
+static u16 get_u16(state_reader *r) {
+    u8 b[2];
+    get_bytes(r, b, 2);
+    return b[0] | (b[1] << 8);
+}
+
+static u32 get_u32(state_reader *r) {
+    u8 b[4];
+    get_bytes(r, b, 4);
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((u32)b[3] << 24);
+}
+
+static void get_u32_array(state_reader *r, u32 *values, u32 count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    get_bytes(r, values, count * 4);
+#else
+    for (u32 i=0; i<count; i++) {
+        values[i] = get_u32(r);
+    }
+#endif
+}
+
+static u32 read_u32(const u8 *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+//with deferred rendering the pixel pipeline lives on the render thread.
+static ppu_context *pipeline_ppu() {
+    ppu_context *render = ppu_deferred_render_context();
+    return render ? render : ppu_get_context();
+}
+
+static void save_cpu(state_writer *w) {
+    cpu_context *cpu = cpu_get_context();
+
+    put_u8(w, cpu->regs.a);
+    put_u8(w, cpu->regs.f);
+    put_u8(w, cpu->regs.b);
+    put_u8(w, cpu->regs.c);
+    put_u8(w, cpu->regs.d);
+    put_u8(w, cpu->regs.e);
+    put_u8(w, cpu->regs.h);
+    put_u8(w, cpu->regs.l);
+    put_u16(w, cpu->regs.pc);
+    put_u16(w, cpu->regs.sp);
+    put_u16(w, cpu->fetched_data);
+    put_u16(w, cpu->mem_dest);
+    put_u8(w, cpu->dest_is_mem);
+    put_u8(w, cpu->cur_opcode);
+    put_u8(w, cpu->halted);
+    put_u8(w, cpu->stepping);
+    put_u8(w, cpu->int_master_enabled);
+    put_u8(w, cpu->enabling_ime);
+    put_u8(w, cpu->ie_register);
+    put_u8(w, cpu->int_flags);
+}
+
+static void load_cpu(state_reader *r) {
+    cpu_context *cpu = cpu_get_context();
+
+    cpu->regs.a = get_u8(r);
+    cpu->regs.f = get_u8(r);
+    cpu->regs.b = get_u8(r);
+    cpu->regs.c = get_u8(r);
+    cpu->regs.d = get_u8(r);
+    cpu->regs.e = get_u8(r);
+    cpu->regs.h = get_u8(r);
+    cpu->regs.l = get_u8(r);
+    cpu->regs.pc = get_u16(r);
+    cpu->regs.sp = get_u16(r);
+    cpu->fetched_data = get_u16(r);
+    cpu->mem_dest = get_u16(r);
+    cpu->dest_is_mem = get_u8(r);
+    cpu->cur_opcode = get_u8(r);
+    cpu->cur_inst = instruction_by_opcode(cpu->cur_opcode);
+    cpu->halted = get_u8(r);
+    cpu->stepping = get_u8(r);
+    cpu->int_master_enabled = get_u8(r);
+    cpu->enabling_ime = get_u8(r);
+    cpu->ie_register = get_u8(r);
+    cpu->int_flags = get_u8(r);
+}
+
+static void save_timer(state_writer *w) {
+    timer_context *timer = timer_get_context();
+
+    put_u16(w, timer->div);
+    put_u8(w, timer->tima);
+    put_u8(w, timer->tma);
+    put_u8(w, timer->tac);
+}
+
+static void load_timer(state_reader *r) {
+    timer_context *timer = timer_get_context();
+
+    timer->div = get_u16(r);
+    timer->tima = get_u8(r);
+    timer->tma = get_u8(r);
+    timer->tac = get_u8(r);
+}
+
+static u8 sprite_index(ppu_context *ppu, oam_line_entry *entry) {
+    return entry ? entry - ppu->line_entry_array : NO_INDEX;
+}
+
+static oam_line_entry *sprite_entry(ppu_context *ppu, u8 index) {
+    return index < 10 ? &ppu->line_entry_array[index] : NULL;
+}
+
+static void save_ppu(state_writer *w) {
+    ppu_context *ppu = pipeline_ppu();
+    pixel_fifo_context *pfc = &ppu->pfc;
+
+    put_bytes(w, ppu->oam_ram, sizeof(ppu->oam_ram));
+    put_pages(w, ppu->vram, VRAM_SIZE);
+
+    put_u8(w, pfc->cur_fetch_state);
+    put_u8(w, pfc->pixel_fifo.size);
+
+    //queued pixels first, the fifo head is 0 after loading.
+    for (int i=0; i<PIXEL_FIFO_SIZE; i++) {
+        put_u32(w, pfc->pixel_fifo.entries[(pfc->pixel_fifo.head + i) & (PIXEL_FIFO_SIZE - 1)]);
+    }
+
+    put_u8(w, pfc->line_x);
+    put_u8(w, pfc->pushed_x);
+    put_u8(w, pfc->fetch_x);
+    put_bytes(w, pfc->bgw_fetch_data, sizeof(pfc->bgw_fetch_data));
+    put_bytes(w, pfc->fetch_entry_data, sizeof(pfc->fetch_entry_data));
+    put_u8(w, pfc->map_y);
+    put_u8(w, pfc->map_x);
+    put_u8(w, pfc->tile_y);
+    put_u8(w, pfc->fifo_x);
+
+    put_u8(w, ppu->line_sprite_count);
+    put_u8(w, sprite_index(ppu, ppu->line_sprites));
+
+    for (int i=0; i<10; i++) {
+        put_bytes(w, &ppu->line_entry_array[i].entry, sizeof(oam_entry));
+        put_u8(w, sprite_index(ppu, ppu->line_entry_array[i].next));
+    }
+
+    put_u8(w, ppu->fetched_entry_count);
+    put_bytes(w, ppu->fetched_entries, sizeof(ppu->fetched_entries));
+    put_u8(w, ppu->window_line);
+    put_u32(w, ppu->line_ticks);
+
+    put_u8(w, ppu->frame_render);
+    put_u8(w, ppu_get_context()->next_frame_render);
+
+    put_u32_array(w, ppu->line_hash, YRES);
+}
+
+static void load_ppu(state_reader *r) {
+    ppu_context *ppu = ppu_get_context();
+    pixel_fifo_context *pfc = &ppu->pfc;
+
+    get_bytes(r, ppu->oam_ram, sizeof(ppu->oam_ram));
+    get_pages(r, ppu->vram, VRAM_SIZE);
+
+    pfc->cur_fetch_state = get_u8(r);
+    pfc->pixel_fifo.head = 0;
+    pfc->pixel_fifo.size = get_u8(r);
+    get_u32_array(r, pfc->pixel_fifo.entries, PIXEL_FIFO_SIZE);
+
+    if (pfc->pixel_fifo.size > PIXEL_FIFO_SIZE) {
+        pfc->pixel_fifo.size = PIXEL_FIFO_SIZE;
+    }
+
+    pfc->line_x = get_u8(r);
+    pfc->pushed_x = get_u8(r);
+    pfc->fetch_x = get_u8(r);
+    get_bytes(r, pfc->bgw_fetch_data, sizeof(pfc->bgw_fetch_data));
+    get_bytes(r, pfc->fetch_entry_data, sizeof(pfc->fetch_entry_data));
+    pfc->map_y = get_u8(r);
+    pfc->map_x = get_u8(r);
+    pfc->tile_y = get_u8(r);
+    pfc->fifo_x = get_u8(r);
+
+    ppu->line_sprite_count = get_u8(r);
+    ppu->line_sprites = sprite_entry(ppu, get_u8(r));
+
+    for (int i=0; i<10; i++) {
+        get_bytes(r, &ppu->line_entry_array[i].entry, sizeof(oam_entry));
+        ppu->line_entry_array[i].next = sprite_entry(ppu, get_u8(r));
+    }
+
+    ppu->fetched_entry_count = get_u8(r);
+    get_bytes(r, ppu->fetched_entries, sizeof(ppu->fetched_entries));
+
+    if (ppu->fetched_entry_count > 3) {
+        ppu->fetched_entry_count = 3;
+    }
+
+    ppu->window_line = get_u8(r);
+    ppu->line_ticks = get_u32(r);
+
+    ppu->frame_render = get_u8(r);
+    ppu->next_frame_render = get_u8(r);
+
+    get_u32_array(r, ppu->line_hash, YRES);
+
+    //frame counters belong to the frontend, the loaded picture is simply
+    //reported as changed on the next frame.
+    for (int y=0; y<YRES; y++) {
+        ppu->line_changed[y] = ppu->current_frame + 1;
+    }
+
+    ppu->changed_frame = ppu->current_frame + 1;
+}
+
+//bytes of the cgb's screen, the dmg's takes an eighth.
+#define SCREEN_BYTES (YRES * XRES * 2)
+
+//5 bits to 8 the way the lcd does it.
+static u32 expand_5bit(u16 c) {
+    return (c << 3) | (c >> 2);
+}
+
+//the picture in what the lcd makes its colors from, little endian 15 bit
+//colors on the cgb and four 2 bit shades to a byte on the dmg. Packed
+//first and written at once, not a call per pixel.
+static void save_screen(state_writer *w) {
+    u32 *video_buffer = pipeline_ppu()->video_buffer;
+    u8 packed[SCREEN_BYTES];
+
+    //a fork that hasn't rendered yet has no picture.
+    if (!video_buffer) {
+        memset(packed, 0, sizeof(packed));
+        put_bytes(w, packed, cart_cgb() ? SCREEN_BYTES : SCREEN_BYTES / 8);
+        return;
+    }
+
+    if (cart_cgb()) {
+        for (int i=0; i<YRES * XRES; i++) {
+            u32 c = video_buffer[i];
+            u16 color = ((c >> 19) & 0x1F) | ((c >> 6) & 0x3E0) | ((c << 7) & 0x7C00);
+
+            packed[i * 2] = color & 0xFF;
+            packed[i * 2 + 1] = color >> 8;
+        }
+
+        put_bytes(w, packed, SCREEN_BYTES);
+        return;
+    }
+
+    //the shades are FF, AA, 55 and 00 in every channel.
+    for (int i=0; i<YRES * XRES; i += 4) {
+        u32 *p = video_buffer + i;
+
+        packed[i >> 2] = (~p[0] >> 6 & 3) | (~p[1] >> 4 & 0xC) | (~p[2] >> 2 & 0x30) | (~p[3] & 0xC0);
+    }
+
+    put_bytes(w, packed, SCREEN_BYTES / 8);
+}
+
+static void load_screen(state_reader *r) {
+    ppu_context *ppu = ppu_get_context();
+    u8 packed[SCREEN_BYTES];
+
+    if (!ppu->video_buffer) {
+        ppu->video_buffer = calloc(YRES * XRES, sizeof(u32));
+    }
+
+    if (cart_cgb()) {
+        get_bytes(r, packed, SCREEN_BYTES);
+
+        for (int i=0; i<YRES * XRES; i++) {
+            u16 c = packed[i * 2] | (packed[i * 2 + 1] << 8);
+
+            ppu->video_buffer[i] = 0xFF000000 | (expand_5bit(c & 0x1F) << 16) |
+                (expand_5bit((c >> 5) & 0x1F) << 8) | expand_5bit((c >> 10) & 0x1F);
+        }
+
+        return;
+    }
+
+    static const u32 shades[4] = { 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000 };
+
+    get_bytes(r, packed, SCREEN_BYTES / 8);
+
+    for (int i=0; i<YRES * XRES; i += 4) {
+        u32 *p = ppu->video_buffer + i;
+        u8 b = packed[i >> 2];
+
+        p[0] = shades[b & 3];
+        p[1] = shades[(b >> 2) & 3];
+        p[2] = shades[(b >> 4) & 3];
+        p[3] = shades[b >> 6];
+    }
+}
+
+static void save_lcd(state_writer *w) {
+    lcd_context *lcd = lcd_get_context();
+
+    put_u8(w, lcd->lcdc);
+    put_u8(w, lcd->lcds);
+    put_u8(w, lcd->scroll_y);
+    put_u8(w, lcd->scroll_x);
+    put_u8(w, lcd->ly);
+    put_u8(w, lcd->ly_compare);
+    put_u8(w, lcd->dma);
+    put_u8(w, lcd->bg_palette);
+    put_u8(w, lcd->obj_palette[0]);
+    put_u8(w, lcd->obj_palette[1]);
+    put_u8(w, lcd->win_y);
+    put_u8(w, lcd->win_x);
+    put_u32_array(w, lcd->bg_colors, 4);
+    put_u32_array(w, lcd->sp1_colors, 4);
+    put_u32_array(w, lcd->sp2_colors, 4);
+}
+
+static void load_lcd(state_reader *r) {
+    lcd_context *lcd = lcd_get_context();
+
+    lcd->lcdc = get_u8(r);
+    lcd->lcds = get_u8(r);
+    lcd->scroll_y = get_u8(r);
+    lcd->scroll_x = get_u8(r);
+    lcd->ly = get_u8(r);
+    lcd->ly_compare = get_u8(r);
+    lcd->dma = get_u8(r);
+    lcd->bg_palette = get_u8(r);
+    lcd->obj_palette[0] = get_u8(r);
+    lcd->obj_palette[1] = get_u8(r);
+    lcd->win_y = get_u8(r);
+    lcd->win_x = get_u8(r);
+    get_u32_array(r, lcd->bg_colors, 4);
+    get_u32_array(r, lcd->sp1_colors, 4);
+    get_u32_array(r, lcd->sp2_colors, 4);
+}
+
+static void save_dma(state_writer *w) {
+    dma_context *dma = dma_get_context();
+
+    dma_sync();
+
+    put_u8(w, dma->active);
+    put_u8(w, dma->byte);
+    put_u8(w, dma->value);
+    put_u8(w, dma->start_delay);
+}
+
+static void load_dma(state_reader *r) {
+    dma_context *dma = dma_get_context();
+
+    dma->active = get_u8(r);
+    dma->byte = get_u8(r);
+    dma->value = get_u8(r);
+    dma->start_delay = get_u8(r);
+    dma_restore();
+}
+
+static void save_ram(state_writer *w) {
+    ram_context *ram = ram_get_context();
+
+    put_pages(w, ram->wram, WRAM_SIZE);
+    put_bytes(w, ram->hram, sizeof(ram->hram));
+}
+
+static void load_ram(state_reader *r) {
+    ram_context *ram = ram_get_context();
+
+    get_pages(r, ram->wram, WRAM_SIZE);
+    get_bytes(r, ram->hram, sizeof(ram->hram));
+}
+
+static void save_cart(state_writer *w) {
+    cart_context *cart = cart_get_context();
+    u16 bank_mask = 0;
+    u8 ram_bank = NO_INDEX;
+
+    for (int i=0; i<cart->ram_bank_count; i++) {
+        bank_mask |= 1 << i;
+
+        if (cart->ram_bank == cart_ram_bank(i)) {
+            ram_bank = i;
+        }
+    }
+
+    put_u8(w, cart->ram_enabled);
+    put_u8(w, cart->ram_banking);
+    put_u8(w, cart->banking_mode);
+    put_u8(w, cart->rom_bank_value & 0xFF);
+    put_u8(w, cart->ram_bank_value);
+    put_u32(w, cart->rom_bank_x - cart->rom_data);
+    put_u8(w, ram_bank);
+    put_u16(w, bank_mask);
+
+    for (int i=0; i<cart->ram_bank_count; i++) {
+        put_pages(w, cart_ram_bank(i), CART_RAM_BANK_SIZE);
+    }
+
+    if (cart->has_rtc) {
+        u64 clock = mbc_rtc_get_clock();
+
+        put_u32(w, clock & 0xFFFFFFFF);
+        put_u32(w, clock >> 32);
+        put_u8(w, cart->rtc.halted);
+        put_u8(w, cart->rtc.carry);
+        put_u8(w, cart->rtc.latch);
+        put_bytes(w, cart->rtc.regs, sizeof(cart->rtc.regs));
+    }
+
+    if (cart->mapper->rom_bank_bits > 8) {
+        put_u8(w, cart->rom_bank_value >> 8);
+    }
+}
+
+//only the battery ram blocks a load changes are saved again, run-ahead
+//loads a state every frame.
+static bool mark_changed(state_reader *r, int bank) {
+    u8 block[1 << CART_DIRTY_SHIFT];
+    bool changed = false;
+
+    for (u32 offset=0; offset<CART_RAM_BANK_SIZE && r->pos + offset + sizeof(block) <= r->size; offset += sizeof(block)) {
+        page_read(cart_ram_bank(bank), offset, block, sizeof(block));
+
+        if (memcmp(block, r->data + r->pos + offset, sizeof(block))) {
+            cart_mark_dirty(bank * CART_RAM_BANK_SIZE + offset, sizeof(block));
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+static void load_cart(state_reader *r) {
+    cart_context *cart = cart_get_context();
+
+    cart->ram_enabled = get_u8(r);
+    cart->ram_banking = get_u8(r);
+    cart->banking_mode = get_u8(r);
+    cart->rom_bank_value = get_u8(r);
+    cart->ram_bank_value = get_u8(r);
+
+    //the rom banks are mapped from the registers below.
+    get_u32(r);
+
+    u8 ram_bank = get_u8(r);
+    cart->ram_bank = ram_bank < CART_RAM_BANKS ? cart_ram_bank(ram_bank) : NULL;
+
+    u16 bank_mask = get_u16(r);
+
+    for (int i=0; i<16; i++) {
+        if (!(bank_mask & (1 << i))) {
+            continue;
+        }
+
+        if (cart_ram_bank(i)) {
+            if (cart->battery && mark_changed(r, i)) {
+                //battery ram now differs from the .battery file.
+                cart->need_save = true;
+            }
+
+            get_pages(r, cart_ram_bank(i), CART_RAM_BANK_SIZE);
+        } else {
+            r->pos += CART_RAM_BANK_SIZE;
+        }
+    }
+
+    if (cart->has_rtc) {
+        u64 clock = get_u32(r);
+        clock |= (u64)get_u32(r) << 32;
+
+        cart->rtc.halted = get_u8(r);
+        cart->rtc.carry = get_u8(r);
+        cart->rtc.latch = get_u8(r);
+        get_bytes(r, cart->rtc.regs, sizeof(cart->rtc.regs));
+
+        //the clock counts on from the loaded time.
+        mbc_rtc_set_clock(clock);
+    }
+
+    if (cart->mapper->rom_bank_bits > 8) {
+        cart->rom_bank_value |= get_u8(r) << 8;
+    }
+
+    cart->mapper->map();
+    cart_map_ram();
+}
+
+static void save_apu(state_writer *w) {
+    sound_context *sound = sound_get_context();
+
+    put_bytes(w, sound->snd_mem, sizeof(sound->snd_mem));
+
+    for (int i=0; i<4; i++) {
+        sndchan *ch = &sound->snd.ch[i];
+
+        put_u32(w, ch->on);
+        put_u32(w, ch->pos);
+        put_u32(w, ch->encnt);
+        put_u32(w, ch->swcnt);
+        put_u32(w, ch->len);
+        put_u32(w, ch->enlen);
+        put_u32(w, ch->swlen);
+        put_u32(w, ch->swfreq);
+
+        //only channel 1 has a sweep.
+        if (i == 0) {
+            put_u32(w, ch->swon);
+            put_u32(w, ch->swneg);
+        }
+
+        put_u32(w, ch->freq);
+        put_u32(w, ch->envol);
+        put_u32(w, ch->endir);
+    }
+
+    put_bytes(w, sound->snd.wave, sizeof(sound->snd.wave));
+    put_u32(w, sound->tick);
+
+    for (int i=0; i<4; i++) {
+        put_u32(w, sound->snd.ch[i].delay);
+        put_u32(w, sound->snd.ch[i].level);
+    }
+
+    put_u32(w, sound->snd.seq);
+}
+
+static void load_apu(state_reader *r) {
+    sound_context *sound = sound_get_context();
+
+    get_bytes(r, sound->snd_mem, sizeof(sound->snd_mem));
+
+    for (int i=0; i<4; i++) {
+        sndchan *ch = &sound->snd.ch[i];
+
+        ch->on = get_u32(r);
+        ch->pos = get_u32(r);
+        ch->encnt = get_u32(r);
+        ch->swcnt = get_u32(r);
+        ch->len = get_u32(r);
+        ch->enlen = get_u32(r);
+        ch->swlen = get_u32(r);
+        ch->swfreq = get_u32(r);
+
+        if (i == 0) {
+            ch->swon = get_u32(r);
+            ch->swneg = get_u32(r);
+        }
+
+        ch->freq = get_u32(r);
+        ch->envol = get_u32(r);
+        ch->endir = get_u32(r);
+    }
+
+    get_bytes(r, sound->snd.wave, sizeof(sound->snd.wave));
+    sound->tick = get_u32(r);
+
+    for (int i=0; i<4; i++) {
+        sound->snd.ch[i].delay = get_u32(r);
+        sound->snd.ch[i].level = get_u32(r);
+    }
+
+    sound->snd.seq = get_u32(r);
+
+    //the periods aren't saved, they follow from the registers.
+    s1_freq();
+    s2_freq();
+    s3_freq();
+    s4_freq();
+}
+
+static void save_joypad(state_writer *w) {
+    //the pressed buttons belong to the frontend, only the selection is saved.
+    put_u8(w, gamepad_get_context()->button_sel);
+    put_u8(w, gamepad_get_context()->dir_sel);
+}
+
+static void load_joypad(state_reader *r) {
+    gamepad_get_context()->button_sel = get_u8(r);
+    gamepad_get_context()->dir_sel = get_u8(r);
+}
+
+static void save_serial(state_writer *w) {
+    put_u8(w, serial_get_context()->sb);
+    put_u8(w, serial_get_context()->sc);
+
+    //0 while idle, the state keeps its size when a transfer starts.
+    put_u32(w, serial_remaining());
+}
+
+static void load_serial(state_reader *r) {
+    serial_get_context()->sb = get_u8(r);
+    serial_get_context()->sc = get_u8(r);
+    serial_restore(get_u32(r));
+}
+
+//empty for dmg games, so their states and hashes don't change.
+static void save_cgb(state_writer *w) {
+    if (!cart_cgb()) {
+        return;
+    }
+
+    cpu_context *cpu = cpu_get_context();
+    ram_context *ram = ram_get_context();
+    lcd_context *lcd = lcd_get_context();
+
+    put_u8(w, cpu->speed_armed);
+    put_u8(w, cpu->double_speed);
+    put_u8(w, ram->svbk);
+    put_pages(w, ram->wram + PAGE_COUNT(WRAM_SIZE), WRAM_CGB_SIZE - WRAM_SIZE);
+    put_pages(w, ppu_get_context()->vram + PAGE_COUNT(VRAM_SIZE), VRAM_CGB_SIZE - VRAM_SIZE);
+    put_u8(w, pipeline_ppu()->pfc.bgw_fetch_attr);
+    put_u8(w, lcd->vbk);
+    put_u8(w, lcd->bcps);
+    put_u8(w, lcd->ocps);
+    put_bytes(w, lcd->bg_palette_ram, sizeof(lcd->bg_palette_ram));
+    put_bytes(w, lcd->obj_palette_ram, sizeof(lcd->obj_palette_ram));
+
+    dma_context *dma = dma_get_context();
+
+    put_u16(w, dma->vram_src);
+    put_u16(w, dma->vram_dst);
+    put_u8(w, dma->vram_blocks);
+    put_u8(w, dma->hblank_active);
+    put_u16(w, dma->stall);
+}
+
+static void load_cgb(state_reader *r) {
+    if (!cart_cgb()) {
+        return;
+    }
+
+    cpu_context *cpu = cpu_get_context();
+    ram_context *ram = ram_get_context();
+    lcd_context *lcd = lcd_get_context();
+
+    cpu->speed_armed = get_u8(r);
+    cpu->double_speed = get_u8(r);
+    ram_svbk_write(get_u8(r));
+    get_pages(r, ram->wram + PAGE_COUNT(WRAM_SIZE), WRAM_CGB_SIZE - WRAM_SIZE);
+    get_pages(r, ppu_get_context()->vram + PAGE_COUNT(VRAM_SIZE), VRAM_CGB_SIZE - VRAM_SIZE);
+    ppu_get_context()->pfc.bgw_fetch_attr = get_u8(r);
+    lcd->vbk = get_u8(r) & 1;
+    lcd->bcps = get_u8(r);
+    lcd->ocps = get_u8(r);
+    get_bytes(r, lcd->bg_palette_ram, sizeof(lcd->bg_palette_ram));
+    get_bytes(r, lcd->obj_palette_ram, sizeof(lcd->obj_palette_ram));
+    lcd_update_cgb_colors();
+
+    dma_context *dma = dma_get_context();
+
+    dma->vram_src = get_u16(r);
+    dma->vram_dst = get_u16(r);
+    dma->vram_blocks = get_u8(r);
+    dma->hblank_active = get_u8(r);
+    dma->stall = get_u16(r);
+}
+
+static const state_section sections[] = {
+    { SECTION_ID('C', 'P', 'U', ' '), save_cpu, load_cpu },
+    { SECTION_ID('T', 'I', 'M', 'R'), save_timer, load_timer },
+    { SECTION_ID('P', 'P', 'U', ' '), save_ppu, load_ppu },
+    { SECTION_ID('S', 'C', 'R', 'N'), save_screen, load_screen },
+    { SECTION_ID('L', 'C', 'D', ' '), save_lcd, load_lcd },
+    { SECTION_ID('D', 'M', 'A', ' '), save_dma, load_dma },
+    { SECTION_ID('R', 'A', 'M', ' '), save_ram, load_ram },
+    { SECTION_ID('C', 'A', 'R', 'T'), save_cart, load_cart },
+    { SECTION_ID('A', 'P', 'U', ' '), save_apu, load_apu },
+    { SECTION_ID('J', 'O', 'Y', 'P'), save_joypad, load_joypad },
+    { SECTION_ID('S', 'I', 'O', ' '), save_serial, load_serial },
+    { SECTION_ID('C', 'G', 'B', ' '), save_cgb, load_cgb },
+};
+
+#define SECTION_COUNT ((int)(sizeof(sections) / sizeof(sections[0])))
+
+static void write_state(state_writer *w) {
+    cart_context *cart = cart_get_context();
+
+    put_bytes(w, "GBST", 4);
+    put_u32(w, STATE_VERSION);
+    put_u32(w, 0); //total size, filled in at the end.
+    put_u32(w, cart->rom_size);
+    put_u16(w, cart->header->global_checksum);
+    put_u8(w, cart->header->header_checksum);
+    put_u8(w, 0);
+
+    for (int i=0; i<SECTION_COUNT; i++) {
+        put_u32(w, sections[i].id);
+        u32 size_pos = w->pos;
+        put_u32(w, 0);
+
+        sections[i].save(w);
+
+        if (w->data && w->pos <= w->size) {
+            u32 payload = w->pos - size_pos - 4;
+            u8 b[4] = { payload & 0xFF, (payload >> 8) & 0xFF, (payload >> 16) & 0xFF, payload >> 24 };
+            memcpy(w->data + size_pos, b, 4);
+        }
+    }
+
+    if (w->data && w->pos <= w->size) {
+        u8 b[4] = { w->pos & 0xFF, (w->pos >> 8) & 0xFF, (w->pos >> 16) & 0xFF, w->pos >> 24 };
+        memcpy(w->data + 8, b, 4);
+    }
+}
+
+u32 state_size() {
+    state_writer w = {0};
+
+    ppu_deferred_flush();
+    write_state(&w);
+
+    return w.pos;
+}
+
+u32 state_save(u8 *buffer, u32 size) {
+    state_writer w = { buffer, size, 0, false, 0 };
+
+    //the render thread has to catch up before its pipeline can be saved.
+    ppu_deferred_flush();
+    write_state(&w);
+
+    if (w.pos > size) {
+        fprintf(stderr, "State buffer too small: %u < %u\n", size, w.pos);
+        return 0;
+    }
+
+    return w.pos;
+}
+
+u64 state_hash() {
+    state_writer w = { NULL, 0, 0, true, 0xCBF29CE484222325ULL };
+    ppu_context *ppu = ppu_get_context();
+
+    for (int i=0; i<SECTION_COUNT; i++) {
+        //the picture and the pixel pipeline depend on frame skipping.
+        if (sections[i].save != save_ppu && sections[i].save != save_screen) {
+            sections[i].save(&w);
+        }
+    }
+
+    put_bytes(&w, ppu->oam_ram, sizeof(ppu->oam_ram));
+    put_pages(&w, ppu->vram, VRAM_SIZE);
+
+    return w.hash;
+}
+
+static const state_section *find_section(u32 id) {
+    for (int i=0; i<SECTION_COUNT; i++) {
+        if (sections[i].id == id) {
+            return &sections[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool state_load(const u8 *buffer, u32 size) {
+    cart_context *cart = cart_get_context();
+
+    if (size < STATE_HEADER_SIZE || memcmp(buffer, "GBST", 4)) {
+        fprintf(stderr, "Not a save state\n");
+        return false;
+    }
+
+    u32 version = read_u32(buffer + 4);
+    u32 total = read_u32(buffer + 8);
+
+    if (version != STATE_VERSION) {
+        fprintf(stderr, "Unsupported save state version: %u\n", version);
+        return false;
+    }
+
+    if (total < STATE_HEADER_SIZE || total > size) {
+        fprintf(stderr, "Save state is truncated\n");
+        return false;
+    }
+
+    if (read_u32(buffer + 12) != cart->rom_size ||
+        (buffer[16] | (buffer[17] << 8)) != cart->header->global_checksum ||
+        buffer[18] != cart->header->header_checksum) {
+        fprintf(stderr, "Save state belongs to another rom\n");
+        return false;
+    }
+
+    //check every section before anything is changed.
+    u32 pos = STATE_HEADER_SIZE;
+
+    while (pos < total) {
+        if (total - pos < SECTION_HEADER_SIZE ||
+            read_u32(buffer + pos + 4) > total - pos - SECTION_HEADER_SIZE) {
+            fprintf(stderr, "Save state is corrupted\n");
+            return false;
+        }
+
+        pos += SECTION_HEADER_SIZE + read_u32(buffer + pos + 4);
+    }
+
+    bool deferred = ppu_deferred_active();
+    ppu_deferred_stop();
+
+    pos = STATE_HEADER_SIZE;
+
+    while (pos < total) {
+        u32 payload = read_u32(buffer + pos + 4);
+        const state_section *section = find_section(read_u32(buffer + pos));
+
+        if (section) {
+            state_reader r = { buffer + pos + SECTION_HEADER_SIZE, payload, 0 };
+            section->load(&r);
+        }
+
+        pos += SECTION_HEADER_SIZE + payload;
+    }
+
+    //the sequencer's next step follows from div and the speed, both loaded now.
+    timer_schedule_sequencer();
+
+    if (deferred) {
+        ppu_deferred_restart();
+    }
+
+    return true;
+}
+
+bool state_save_file(const char *filename) {
+    u32 size = state_size();
+    u8 *buffer = malloc(size);
+
+    if (!state_save(buffer, size)) {
+        free(buffer);
+        return false;
+    }
+
+    FILE *fp = fopen(filename, "wb");
+
+    if (!fp) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", filename);
+        free(buffer);
+        return false;
+    }
+
+    bool ok = fwrite(buffer, size, 1, fp) == 1;
+    fclose(fp);
+    free(buffer);
+
+    return ok;
+}
+
+bool state_load_file(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+
+    if (!fp) {
+        fprintf(stderr, "FAILED TO OPEN: %s\n", filename);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    if (size <= 0) {
+        fclose(fp);
+        return false;
+    }
+
+    u8 *buffer = malloc(size);
+    bool ok = fread(buffer, size, 1, fp) == 1 && state_load(buffer, size);
+
+    fclose(fp);
+    free(buffer);
+
+    return ok;
+}
@@ -1,43 +1,68 @@
 #include <timer.h>
 #include <interrupts.h>
+#include <scheduler.h>
+#include <sound.h>
+#include <cpu.h>
 
-static timer_context ctx = {0};
+static timer_context main_ctx;
+static _Thread_local timer_context *ctx = &main_ctx;
 
 timer_context *timer_get_context() {
-    return &ctx;
+    return ctx;
+}
+
+void timer_set_context(timer_context *context) {
+    ctx = context;
 }
 
 void timer_init() {
-    ctx.div = 0xAC00;
+    ctx->div = 0xAC00;
+    timer_schedule_sequencer();
+}
+
+static u16 sequencer_bit() {
+    return cpu_get_context()->double_speed ? 1 << 13 : 1 << 12;
+}
+
+//div counts four a cpu cycle at either speed.
+void timer_schedule_sequencer() {
+    u16 period = sequencer_bit() << 1;
+
+    scheduler_add(SCHED_FRAME_SEQUENCER, (period - (ctx->div & (period - 1))) / 4);
+}
+
+void timer_frame_sequencer() {
+    sound_frame_sequencer();
+    timer_schedule_sequencer();
 }
 
 void timer_tick() {
-    u16 prev_div = ctx.div;
+    u16 prev_div = ctx->div;
 
-    ctx.div++;
+    ctx->div++;
 
     bool timer_update = false;
 
-    switch(ctx.tac & (0b11)) {
+    switch(ctx->tac & (0b11)) {
         case 0b00:
-            timer_update = (prev_div & (1 << 9)) && (!(ctx.div & (1 << 9)));
+            timer_update = (prev_div & (1 << 9)) && (!(ctx->div & (1 << 9)));
             break;
         case 0b01:
-            timer_update = (prev_div & (1 << 3)) && (!(ctx.div & (1 << 3)));
+            timer_update = (prev_div & (1 << 3)) && (!(ctx->div & (1 << 3)));
             break;
         case 0b10:
-            timer_update = (prev_div & (1 << 5)) && (!(ctx.div & (1 << 5)));
+            timer_update = (prev_div & (1 << 5)) && (!(ctx->div & (1 << 5)));
             break;
         case 0b11:
-            timer_update = (prev_div & (1 << 7)) && (!(ctx.div & (1 << 7)));
+            timer_update = (prev_div & (1 << 7)) && (!(ctx->div & (1 << 7)));
             break;
     }
 
-    if (timer_update && ctx.tac & (1 << 2)) {
-        ctx.tima++;
+    if (timer_update && ctx->tac & (1 << 2)) {
+        ctx->tima++;
 
-        if (ctx.tima == 0xFF) {
-            ctx.tima = ctx.tma;
+        if (ctx->tima == 0xFF) {
+            ctx->tima = ctx->tma;
 
             cpu_request_interrupt(IT_TIMER);
         }
@@ -47,23 +72,28 @@ void timer_tick() {
 void timer_write(u16 address, u8 value) {
     switch(address) {
         case 0xFF04:
-            //DIV
-            ctx.div = 0;
+            //DIV, a reset while the sequencer's bit is set makes it fall.
+            if (ctx->div & sequencer_bit()) {
+                sound_frame_sequencer();
+            }
+
+            ctx->div = 0;
+            timer_schedule_sequencer();
             break;
 
         case 0xFF05:
             //TIMA
-            ctx.tima = value;
+            ctx->tima = value;
             break;
 
         case 0xFF06:
             //TMA
-            ctx.tma = value;
+            ctx->tma = value;
             break;
 
         case 0xFF07:
             //TAC
-            ctx.tac = value;
+            ctx->tac = value;
             break;
     }
 }
@@ -71,12 +101,12 @@ void timer_write(u16 address, u8 value) {
 u8 timer_read(u16 address) {
     switch(address) {
         case 0xFF04:
-            return ctx.div >> 8;
+            return ctx->div >> 8;
         case 0xFF05:
-            return ctx.tima;
+            return ctx->tima;
         case 0xFF06:
-            return ctx.tma;
+            return ctx->tma;
         case 0xFF07:
-            return ctx.tac;
+            return ctx->tac;
     }
 }
@@ -22,6 +22,10 @@ int systemSpeed = 0;
 int showRenderedFrames = 0;
 int renderedFrames = 0;
 
+//frame that was last presented, only lines changed after it are uploaded.
+static u32 presented_frame = 0;
+static bool force_present = true;
+
 void ui_init() {
     SDL_Init(SDL_INIT_VIDEO);
 
@@ -133,8 +137,26 @@ void ui_update() {
     rc.w = rc.h = 2048;
 
     u32 *video_buffer = ppu_get_context()->video_buffer;
+    u32 frame = ppu_get_context()->current_frame;
+    u8 first_line = 0;
+    u8 last_line = YRES - 1;
+
+    if (!ppu_frame_changed(presented_frame, &first_line, &last_line) && !force_present) {
+        //same picture as the last frame, nothing to upload or present.
+        presented_frame = frame;
+        systemShowSpeed(0);
+        return;
+    }
+
+    if (force_present) {
+        first_line = 0;
+        last_line = YRES - 1;
+        force_present = false;
+    }
+
+    presented_frame = frame;
 
-    for (int line_num = 0; line_num < YRES; line_num++) {
+    for (int line_num = first_line; line_num <= last_line; line_num++) {
         for (int x = 0; x < XRES; x++) {
             rc.x = x * scale;
             rc.y = line_num * scale;
@@ -145,7 +167,13 @@ void ui_update() {
         }
     }
 
-    SDL_UpdateTexture(sdlTexture, NULL, screen->pixels, screen->pitch);
+    //only upload the rows that changed.
+    rc.x = 0;
+    rc.y = first_line * scale;
+    rc.w = SCREEN_WIDTH;
+    rc.h = (last_line - first_line + 1) * scale;
+
+    SDL_UpdateTexture(sdlTexture, &rc, (u8 *)screen->pixels + (rc.y * screen->pitch), screen->pitch);
     SDL_RenderClear(sdlRenderer);
     SDL_RenderCopy(sdlRenderer, sdlTexture, NULL, NULL);
     SDL_RenderPresent(sdlRenderer);
@@ -167,6 +195,9 @@ void ui_on_key(bool down, u32 key_code) {
         case SDLK_s: gamepad_get_state()->down = down; break;
         case SDLK_a: gamepad_get_state()->left = down; break;
         case SDLK_d: gamepad_get_state()->right = down; break;
+        case SDLK_F5: if (down) emu_get_context()->save_state = true; break;
+        case SDLK_F8: if (down) emu_get_context()->load_state = true; break;
+        case SDLK_BACKSPACE: emu_get_context()->rewinding = down; break;
     }
 }
 
@@ -186,9 +217,18 @@ void ui_handle_events() {
             emu_get_context()->die = true;
         }
 
+        if (e.type == SDL_WINDOWEVENT && (e.window.event == SDL_WINDOWEVENT_EXPOSED ||
+                e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
+            //window needs to be drawn again even if the picture is the same.
+            force_present = true;
+        }
+
         if (e.type == SDL_DROPFILE) {
             char *dropped_file = e.drop.file;
             systemSetTitle(dropped_file);
+            presented_frame = 0;
+            force_present = true;
+
             if (run_game(dropped_file)) {
                 systemSetTitle("Load rom failed");
                 emu_get_context()->running = false;
@@ -0,0 +1,395 @@
+#include <vecenv.h>
+#include <machine.h>
+#include <state.h>
+#include <bus.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef enum {
+    OP_BOOT,
+    OP_RESET,
+    OP_STEP,
+    OP_FREE,
+    OP_EXIT
+} vecenv_op;
+
+typedef struct {
+    machine *m;
+    u32 episode_frames;
+    bool done;
+} vecenv_slot;
+
+struct vecenv {
+    vecenv_config config;
+    u16 *ram_addresses;
+    u32 obs_size;
+
+    u8 *rom;
+    u32 rom_size;
+
+    //every episode starts from this state, taken by the first machine.
+    u8 *start_state;
+    u32 state_size;
+
+    vecenv_slot *slots;
+    atomic_int failed;
+
+    pthread_t *workers;
+    int threads;
+
+    //one op at a time, workers take the machines in order.
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finished;
+    u32 generation;
+    int busy;
+
+    vecenv_op op;
+    int first;
+    int count;
+    atomic_int next;
+
+    const u8 *actions;
+    int frames_per_step;
+    u8 *obs;
+    u8 *done;
+};
+
+static void write_obs(vecenv *env, int index) {
+    u8 *obs = env->obs + (size_t)index * env->obs_size;
+
+    if (env->config.obs_type == VECENV_OBS_RAM) {
+        for (int i=0; i<env->config.ram_count; i++) {
+            obs[i] = bus_read(env->ram_addresses[i]);
+        }
+
+        return;
+    }
+
+    u32 *video = ppu_get_context()->video_buffer;
+    int d = env->config.downsample;
+    int shift = d == 4 ? 4 : (d == 2 ? 2 : 0);
+
+    for (int y=0; y<YRES / d; y++) {
+        for (int x=0; x<XRES / d; x++) {
+            u32 sum = 0;
+
+            for (int dy=0; dy<d; dy++) {
+                u32 *row = video + (y * d + dy) * XRES + x * d;
+
+                for (int dx=0; dx<d; dx++) {
+                    u32 c = row[dx];
+                    sum += (((c >> 16) & 0xFF) * 77 + ((c >> 8) & 0xFF) * 150 + (c & 0xFF) * 29) >> 8;
+                }
+            }
+
+            *obs++ = sum >> shift;
+        }
+    }
+}
+
+static void boot(vecenv *env, int index) {
+    vecenv_slot *slot = &env->slots[index];
+
+    slot->m = machine_new();
+
+    if (!slot->m) {
+        atomic_fetch_add(&env->failed, 1);
+        return;
+    }
+
+    machine_bind(slot->m);
+
+    //all machines share one copy of the rom.
+    cart_init(env->rom, env->rom_size);
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sound_init(0, 0);
+
+    emu_get_context()->running = true;
+    emu_get_context()->fast_forward = true;
+
+    if (index == 0) {
+        if (env->config.state_file && !state_load_file((char *)env->config.state_file)) {
+            atomic_fetch_add(&env->failed, 1);
+            return;
+        }
+
+        env->state_size = state_size();
+        env->start_state = malloc(env->state_size);
+        state_save(env->start_state, env->state_size);
+    } else {
+        state_load(env->start_state, env->state_size);
+    }
+}
+
+static void reset(vecenv *env, int index) {
+    vecenv_slot *slot = &env->slots[index];
+
+    state_load(env->start_state, env->state_size);
+    slot->episode_frames = 0;
+    slot->done = false;
+}
+
+static void step(vecenv *env, int index) {
+    vecenv_slot *slot = &env->slots[index];
+    bool screen = env->config.obs_type == VECENV_OBS_SCREEN;
+    int frames = env->frames_per_step;
+
+    if (slot->done) {
+        reset(env, index);
+    }
+
+    gamepad_unpack(env->actions[index], &gamepad_get_context()->controller);
+
+    ppu_context *ppu = ppu_get_context();
+    u32 prev_frame = ppu->current_frame;
+
+    //the frame that ends the step is the only one rendered.
+    ppu_set_frame_render(screen && frames == 1);
+
+    for (int f=1; f<=frames && !slot->done; ) {
+        if (!cpu_step()) {
+            slot->done = true;
+            break;
+        }
+
+        if (prev_frame != ppu->current_frame) {
+            prev_frame = ppu->current_frame;
+            ppu_set_frame_render(screen && f + 1 == frames);
+            slot->episode_frames++;
+            f++;
+        }
+    }
+
+    if (env->config.max_episode_frames && slot->episode_frames >= env->config.max_episode_frames) {
+        slot->done = true;
+    }
+
+    if (!slot->done && env->config.done) {
+        slot->done = env->config.done(index, slot->episode_frames, env->config.user);
+    }
+
+    if (env->done) {
+        env->done[index] = slot->done;
+    }
+}
+
+static void run_op(vecenv *env, vecenv_op op, int index) {
+    if (op == OP_BOOT) {
+        boot(env, index);
+        return;
+    }
+
+    if (!env->slots[index].m) {
+        return;
+    }
+
+    if (op == OP_FREE) {
+        machine_free(env->slots[index].m);
+        env->slots[index].m = NULL;
+        return;
+    }
+
+    machine_bind(env->slots[index].m);
+
+    if (op == OP_RESET) {
+        reset(env, index);
+    } else {
+        step(env, index);
+    }
+
+    if (env->obs) {
+        write_obs(env, index);
+    }
+}
+
+static void *worker_run(void *p) {
+    vecenv *env = p;
+    u32 generation = 0;
+
+    while (true) {
+        pthread_mutex_lock(&env->lock);
+
+        while (env->generation == generation) {
+            pthread_cond_wait(&env->start, &env->lock);
+        }
+
+        generation = env->generation;
+        vecenv_op op = env->op;
+
+        pthread_mutex_unlock(&env->lock);
+
+        if (op == OP_EXIT) {
+            return 0;
+        }
+
+        for (int i = atomic_fetch_add(&env->next, 1); i < env->count; i = atomic_fetch_add(&env->next, 1)) {
+            run_op(env, op, env->first + i);
+        }
+
+        pthread_mutex_lock(&env->lock);
+
+        if (--env->busy == 0) {
+            pthread_cond_signal(&env->finished);
+        }
+
+        pthread_mutex_unlock(&env->lock);
+    }
+}
+
+static void dispatch(vecenv *env, vecenv_op op, int first, int count) {
+    pthread_mutex_lock(&env->lock);
+
+    env->op = op;
+    env->first = first;
+    env->count = count;
+    atomic_store(&env->next, 0);
+    env->busy = env->threads;
+    env->generation++;
+
+    pthread_cond_broadcast(&env->start);
+
+    while (op != OP_EXIT && env->busy) {
+        pthread_cond_wait(&env->finished, &env->lock);
+    }
+
+    pthread_mutex_unlock(&env->lock);
+}
+
+static bool read_rom(vecenv *env, const char *rom_file) {
+    FILE *fp = fopen(rom_file, "rb");
+
+    if (!fp) {
+        printf("Failed to open file: %s\n", rom_file);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    env->rom_size = ftell(fp);
+    rewind(fp);
+
+    env->rom = malloc(env->rom_size);
+    bool ok = env->rom_size > 0x150 && fread(env->rom, env->rom_size, 1, fp) == 1;
+    fclose(fp);
+
+    if (!ok) {
+        printf("Not a rom file: %s\n", rom_file);
+    }
+
+    return ok;
+}
+
+vecenv *vecenv_new(const char *rom_file, const vecenv_config *config) {
+    if (config->envs < 1 || (config->obs_type == VECENV_OBS_RAM && config->ram_count < 1)) {
+        return NULL;
+    }
+
+    vecenv *env = calloc(1, sizeof(vecenv));
+    env->config = *config;
+
+    if (env->config.obs_type == VECENV_OBS_RAM) {
+        env->ram_addresses = malloc(config->ram_count * sizeof(u16));
+        memcpy(env->ram_addresses, config->ram_addresses, config->ram_count * sizeof(u16));
+        env->obs_size = config->ram_count;
+    } else {
+        int d = config->downsample;
+        env->config.downsample = d >= 4 ? 4 : (d >= 2 ? 2 : 1);
+        env->obs_size = (XRES / env->config.downsample) * (YRES / env->config.downsample);
+    }
+
+    if (!read_rom(env, rom_file)) {
+        free(env->ram_addresses);
+        free(env->rom);
+        free(env);
+        return NULL;
+    }
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    env->threads = config->threads > 0 ? config->threads : (cores > 0 ? cores : 1);
+
+    if (env->threads > config->envs) {
+        env->threads = config->envs;
+    }
+
+    env->slots = calloc(config->envs, sizeof(vecenv_slot));
+    env->workers = calloc(env->threads, sizeof(pthread_t));
+
+    pthread_mutex_init(&env->lock, NULL);
+    pthread_cond_init(&env->start, NULL);
+    pthread_cond_init(&env->finished, NULL);
+
+    for (int i=0; i<env->threads; i++) {
+        if (pthread_create(&env->workers[i], NULL, worker_run, env)) {
+            fprintf(stderr, "FAILED TO START VECENV WORKER THREAD!\n");
+            exit(-1);
+        }
+    }
+
+    cart_set_quiet(true);
+
+    //the first machine makes the start state the others load.
+    dispatch(env, OP_BOOT, 0, 1);
+
+    if (!env->failed) {
+        dispatch(env, OP_BOOT, 1, config->envs - 1);
+    }
+
+    if (env->failed) {
+        vecenv_free(env);
+        return NULL;
+    }
+
+    return env;
+}
+
+void vecenv_free(vecenv *env) {
+    if (!env) {
+        return;
+    }
+
+    dispatch(env, OP_FREE, 0, env->config.envs);
+    dispatch(env, OP_EXIT, 0, 0);
+
+    for (int i=0; i<env->threads; i++) {
+        pthread_join(env->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&env->lock);
+    pthread_cond_destroy(&env->start);
+    pthread_cond_destroy(&env->finished);
+
+    free(env->workers);
+    free(env->slots);
+    free(env->start_state);
+    free(env->rom);
+    free(env->ram_addresses);
+    free(env);
+}
+
+int vecenv_count(vecenv *env) {
+    return env->config.envs;
+}
+
+u32 vecenv_obs_size(vecenv *env) {
+    return env->obs_size;
+}
+
+void vecenv_reset(vecenv *env, u8 *obs) {
+    env->obs = obs;
+    dispatch(env, OP_RESET, 0, env->config.envs);
+}
+
+void vecenv_step(vecenv *env, const u8 *actions, int frames_per_step, u8 *obs, u8 *done) {
+    env->actions = actions;
+    env->frames_per_step = frames_per_step > 0 ? frames_per_step : 1;
+    env->obs = obs;
+    env->done = done;
+
+    dispatch(env, OP_STEP, 0, env->config.envs);
+}